@@ -19,11 +19,69 @@
    #error "You may not have both __linux__ and [WIN32|_WIN32|__WIN32|__CYGWIN__] defined"
 #endif
 
+/*!
+ * The toolkit used to create message boxes. Qt is used on any platform if BOXER_USE_QT is defined, otherwise GTK is used
+ * on Linux and the Win32 API on Windows.
+ */
+#if defined(BOXER_USE_QT)
+#define BOXER_BACKEND_QT
+#elif defined(__linux__)
+#define BOXER_BACKEND_GTK
+#elif defined(WINDOWS)
+#define BOXER_BACKEND_WIN32
+#endif // defined(BOXER_USE_QT)
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
-#if defined(__linux__)
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#define BOXER_HAS_STRING_VIEW
+#include <string_view>
+#endif // __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+
+#if defined(BOXER_ENABLE_ALLOCATION_STATS)
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#endif // defined(BOXER_ENABLE_ALLOCATION_STATS)
+
+#if defined(BOXER_BACKEND_QT)
+#include <QAbstractButton>
+#include <QApplication>
+#include <QEventLoop>
+#include <QImage>
+#include <QMessageBox>
+#include <QPixmap>
+#include <QThread>
+#include <QTimer>
+#elif defined(BOXER_BACKEND_GTK)
 #include <gtk/gtk.h>
+#endif // defined(BOXER_BACKEND_QT/BOXER_BACKEND_GTK)
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #elif defined(WINDOWS)
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
@@ -70,12 +128,14 @@ enum class Buttons
    OK,
    OKCancel,
    YesNo,
-   Quit
+   Quit,
+   AbortRetryIgnore
 };
 
 /*!
  * Possible responses from a message box. 'None' signifies that no option was chosen, and 'Error' signifies that an
- * error was encountered while creating the message box.
+ * error was encountered while creating the message box. New options are only ever appended, so that the values of
+ * existing ones stay the same across versions (e.g. for prebuilt DLLs).
  */
 enum class Selection
 {
@@ -85,226 +145,3924 @@ enum class Selection
    No,
    Quit,
    None,
-   Error
+   Error,
+   Abort,
+   Retry,
+   Ignore,
+   IgnoreAlways
+};
+
+#if defined(BOXER_ENABLE_ALLOCATION_STATS)
+/*!
+ * Heap allocations made on the calling thread during a single message box. Boxer's allocations are those made through
+ * operator new, the toolkit's are the remaining calls to the malloc family (only tracked on glibc-based systems). As
+ * Qt allocates through operator new as well, its allocations are counted as Boxer's when using the Qt backend.
+ */
+struct AllocationStats
+{
+   std::size_t boxerAllocations;
+   std::size_t boxerBytes;
+   std::size_t toolkitAllocations;
+   std::size_t toolkitBytes;
+};
+#endif // defined(BOXER_ENABLE_ALLOCATION_STATS)
+
+/*!
+ * States of a message box as reported by listDialogs(). 'Pending' message boxes are waiting for an earlier one to be
+ * dismissed before they can be shown.
+ */
+enum class DialogState
+{
+   Pending,
+   Open
+};
+
+/*!
+ * The maximum number of message boxes that can be reported by listDialogs() at once
+ */
+constexpr std::size_t kMaxTrackedDialogs = 64;
+
+/*!
+ * The size of the buffer holding a message box's title in DialogInfo, including the null terminator. Longer titles are
+ * truncated.
+ */
+constexpr std::size_t kMaxDialogTitleLength = 128;
+
+/*!
+ * A snapshot of an open or pending message box
+ */
+struct DialogInfo
+{
+   char title[kMaxDialogTitleLength];
+   Style style;
+   DialogState state;
+   std::chrono::milliseconds age;
+   unsigned long threadId;
+   std::size_t queuePosition;
+};
+
+/*!
+ * Rules for escalating a message box that is left unanswered. After 'raiseAfter' the message box is raised and
+ * highlighted, after 'notifyAfter' it is passed to 'notify' (e.g. to send a notification, or write to a spool file or
+ * an audit log), and after 'resolveAfter' it is answered with 'resolution'. A message box without a button for
+ * 'resolution' is closed instead, and show() returns 'None'. Stages with a delay of zero are skipped.
+ */
+struct EscalationPolicy
+{
+   std::chrono::milliseconds raiseAfter{ 0 };
+   std::chrono::milliseconds notifyAfter{ 0 };
+   std::chrono::milliseconds resolveAfter{ 0 };
+   Selection resolution = Selection::None;
+   std::function<void(const char* message, const char* title, Style style)> notify;
+};
+
+/*!
+ * The number of times each escalation stage has been applied
+ */
+struct EscalationCounters
+{
+   std::uint64_t raised;
+   std::uint64_t notified;
+   std::uint64_t resolved;
+};
+
+/*!
+ * How much work to spend on a message box that requires synchronous round-trips to the display server. 'Minimal'
+ * leaves out everything that is not needed to show the message box, such as centering it and enumerating input
+ * devices, which matters on high-latency connections like X11 forwarding over SSH. 'Auto' uses 'Minimal' when the X11
+ * display is on a remote host. Only affects GTK.
+ */
+enum class RoundTripMode
+{
+   Auto,
+   Standard,
+   Minimal
+};
+
+/*!
+ * Memory pressure as reported by the Linux pressure stall information (PSI). 'Unknown' signifies that memory pressure
+ * is not being watched.
+ */
+enum class MemoryPressure
+{
+   Unknown,
+   Normal,
+   High
+};
+
+/*!
+ * Settings for watchMemoryPressure(). Memory pressure is high once tasks have stalled on memory for 'stall' within
+ * 'window', and drops back to normal after 'holdTime' passes without another stall. 'path' may also name the
+ * 'memory.pressure' file of a cgroup (v2) to only watch the pressure on the service's own cgroup. Unprivileged
+ * processes are limited to windows that are multiples of two seconds.
+ */
+struct MemoryPressureOptions
+{
+   std::string path = "/proc/pressure/memory";
+   std::chrono::microseconds stall{ 150000 };
+   std::chrono::microseconds window{ 2000000 };
+   std::chrono::milliseconds holdTime{ 10000 };
+};
+
+/*!
+ * The current memory pressure, the number of times it has been detected and the number of message boxes that were
+ * shown without a toolkit because of it
+ */
+struct MemoryPressureStatus
+{
+   MemoryPressure pressure;
+   std::uint64_t triggers;
+   std::uint64_t fallbacks;
+};
+
+/*!
+ * The outcome of shutdown(). Each phase's duration is measured separately: answering pending message boxes, closing
+ * open ones, and releasing the toolkit state. 'completed' is false if message boxes were still open at the deadline.
+ */
+struct ShutdownReport
+{
+   std::chrono::microseconds pendingDuration;
+   std::chrono::microseconds closeDuration;
+   std::chrono::microseconds teardownDuration;
+   std::size_t pendingDialogs;
+   std::size_t openDialogs;
+   bool completed;
 };
 
 namespace
 {
+   /*!
+    * A message box tracked for introspection. Each slot is only ever written by the thread showing its message box,
+    * and readers take a snapshot of it through a sequence lock, so reading never blocks the writer (or vice versa)
+    * and is safe from signal handlers.
+    */
+   struct DialogSlot
+   {
+      std::atomic<bool> claimed;
+      std::atomic<unsigned int> sequence;
+      std::atomic<int> state; // 0 when the slot is free, otherwise one more than the DialogState
+      std::atomic<int> style;
+      std::atomic<std::int64_t> startTime;
+      std::atomic<unsigned long> threadId;
+      std::atomic<std::uint64_t> ticket;
+      std::atomic<char> title[kMaxDialogTitleLength];
+   };
+
+   DialogSlot dialogSlots[kMaxTrackedDialogs];
+
+   /*!
+    * Message boxes are shown in the order of their tickets. The ticket being served is the one of the open message
+    * box, the difference to it is a pending message box's position in the queue.
+    */
+   std::atomic<std::uint64_t> servingTicket;
+   std::uint64_t nextTicket = 0;
+   std::mutex queueMutex;
+
+   /*!
+    * The thread showing the message box of the ticket being served, or 0 if there is none. Only accessed while holding
+    * 'queueMutex'.
+    */
+   unsigned long servingThread = 0;
+   std::condition_variable queueCondition;
+
+   /*!
+    * Set once by shutdown(), after which message boxes are answered with 'shutdownSelection' instead of being shown
+    */
+   std::atomic<bool> shuttingDown;
+   std::atomic<int> shutdownSelection(static_cast<int>(Selection::None));
+
+   /*!
+    * Resolves the queued message boxes of each live Overlay when shutdown() is called. Overlays are defined further
+    * down, so each one registers a callback for its lifetime, keyed by its address.
+    */
+   std::mutex overlaysMutex;
+   std::unordered_map<const void*, std::function<void()>> overlayResolvers;
+
+   std::int64_t nowNanoseconds()
+   {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+         std::chrono::steady_clock::now().time_since_epoch()).count();
+   }
+
+   unsigned long getThreadId()
+   {
 #if defined(__linux__)
-   GtkMessageType getMessageType(Style style)
+      return static_cast<unsigned long>(syscall(SYS_gettid));
+#elif defined(WINDOWS)
+      return static_cast<unsigned long>(GetCurrentThreadId());
+#endif // defined(__linux__/WINDOWS)
+   }
+
+   /*!
+    * Registers a message box for introspection for as long as it is in scope. With GTK this also waits for the message
+    * box's turn, as GTK may only be used by one thread at a time. (Qt needs no queue, as its message boxes are only
+    * ever shown on the GUI thread, see getApplication().) A message box shown from the thread whose turn it is (e.g.
+    * from a callback run by the open message box's event loop) is nested in that turn rather than queued behind it, as
+    * it would otherwise wait on itself. A message box is not admitted once shutdown() has been called, even if it was
+    * already waiting.
+    */
+   class TrackedDialog
    {
-      switch (style)
+   public:
+      TrackedDialog(const char* title, std::size_t titleLength, Style style)
       {
-      case Style::Info:
-         return GTK_MESSAGE_INFO;
-      case Style::Warning:
-         return GTK_MESSAGE_WARNING;
-      case Style::Error:
-         return GTK_MESSAGE_ERROR;
-      case Style::Question:
-         return GTK_MESSAGE_QUESTION;
-      default:
-         return GTK_MESSAGE_INFO;
+         std::uint64_t ticket = 0;
+         unsigned long threadId = getThreadId();
+#if defined(BOXER_BACKEND_GTK)
+         {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if (shuttingDown.load(std::memory_order_relaxed))
+            {
+               return;
+            }
+
+            nested = servingThread == threadId;
+            ticket = nested ? servingTicket.load(std::memory_order_relaxed) : nextTicket++;
+         }
+#else // defined(BOXER_BACKEND_GTK)
+         if (shuttingDown.load(std::memory_order_relaxed))
+         {
+            return;
+         }
+#endif // defined(BOXER_BACKEND_GTK)
+
+         for (DialogSlot& candidate : dialogSlots)
+         {
+            bool expected = false;
+            if (candidate.claimed.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            {
+               slot = &candidate;
+               break;
+            }
+         }
+
+         if (slot)
+         {
+            beginWrite();
+            slot->style.store(static_cast<int>(style), std::memory_order_relaxed);
+            slot->startTime.store(nowNanoseconds(), std::memory_order_relaxed);
+            slot->threadId.store(threadId, std::memory_order_relaxed);
+            slot->ticket.store(ticket, std::memory_order_relaxed);
+            std::size_t i = 0;
+            for (; i < titleLength && i < kMaxDialogTitleLength - 1; ++i)
+            {
+               slot->title[i].store(title[i], std::memory_order_relaxed);
+            }
+            slot->title[i].store('\0', std::memory_order_relaxed);
+            slot->state.store(static_cast<int>(DialogState::Pending) + 1, std::memory_order_relaxed);
+            endWrite();
+         }
+
+#if defined(BOXER_BACKEND_GTK)
+         if (!nested)
+         {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [ticket]
+            {
+               return servingTicket.load(std::memory_order_relaxed) == ticket
+                  || shuttingDown.load(std::memory_order_relaxed);
+            });
+
+            // Shutting down skips the tickets of the message boxes still waiting, including one whose turn came up
+            // after shutdown() was called, so the queue is not served again
+            if (servingTicket.load(std::memory_order_relaxed) != ticket || shuttingDown.load(std::memory_order_relaxed))
+            {
+               return;
+            }
+            servingThread = threadId;
+            serving = true;
+         }
+#endif // defined(BOXER_BACKEND_GTK)
+
+         // shutdown() may have been called after the first check, but before the slot made this message box visible to
+         // it. With the fence here and the one in shutdown(), either shutdown() sees the slot and waits for the message
+         // box, or the message box sees that it should not be shown.
+         std::atomic_thread_fence(std::memory_order_seq_cst);
+         if (shuttingDown.load(std::memory_order_relaxed))
+         {
+            return;
+         }
+
+         admitted = true;
+         setState(DialogState::Open);
+      }
+
+      ~TrackedDialog()
+      {
+         if (slot)
+         {
+            beginWrite();
+            slot->state.store(0, std::memory_order_relaxed);
+            endWrite();
+            slot->claimed.store(false, std::memory_order_release);
+         }
+
+#if defined(BOXER_BACKEND_GTK)
+         if (serving)
+         {
+            {
+               std::lock_guard<std::mutex> lock(queueMutex);
+               servingThread = 0;
+               servingTicket.fetch_add(1, std::memory_order_relaxed);
+            }
+            queueCondition.notify_all();
+         }
+#endif // defined(BOXER_BACKEND_GTK)
+      }
+
+      TrackedDialog(const TrackedDialog&) = delete;
+      TrackedDialog& operator=(const TrackedDialog&) = delete;
+
+      /*!
+       * Whether the message box may be shown. If not, it should be answered with 'shutdownSelection' right away.
+       */
+      bool isAdmitted() const
+      {
+         return admitted;
+      }
+
+   private:
+      void beginWrite()
+      {
+         slot->sequence.store(slot->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+         std::atomic_thread_fence(std::memory_order_release);
+      }
+
+      void endWrite()
+      {
+         slot->sequence.store(slot->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+      }
+
+      void setState(DialogState state)
+      {
+         if (slot)
+         {
+            beginWrite();
+            slot->state.store(static_cast<int>(state) + 1, std::memory_order_relaxed);
+            endWrite();
+         }
+      }
+
+      DialogSlot* slot = nullptr;
+      bool admitted = false;
+      bool nested = false;
+      bool serving = false;
+   };
+
+   /*!
+    * Takes a consistent snapshot of a slot without blocking. Returns false if the slot is free, or if it kept changing
+    * while being read.
+    */
+   bool readDialogSlot(const DialogSlot& slot, DialogInfo& info, std::int64_t now)
+   {
+      for (int attempt = 0; attempt < 8; ++attempt)
+      {
+         unsigned int sequence = slot.sequence.load(std::memory_order_acquire);
+         if (sequence % 2 != 0)
+         {
+            continue;
+         }
+
+         int state = slot.state.load(std::memory_order_relaxed);
+         info.style = static_cast<Style>(slot.style.load(std::memory_order_relaxed));
+         std::int64_t startTime = slot.startTime.load(std::memory_order_relaxed);
+         info.threadId = slot.threadId.load(std::memory_order_relaxed);
+         std::uint64_t ticket = slot.ticket.load(std::memory_order_relaxed);
+         for (std::size_t i = 0; i < kMaxDialogTitleLength; ++i)
+         {
+            info.title[i] = slot.title[i].load(std::memory_order_relaxed);
+         }
+
+         std::atomic_thread_fence(std::memory_order_acquire);
+         if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+         {
+            continue;
+         }
+
+         if (state == 0)
+         {
+            return false;
+         }
+
+         std::uint64_t serving = servingTicket.load(std::memory_order_relaxed);
+         info.title[kMaxDialogTitleLength - 1] = '\0';
+         info.state = static_cast<DialogState>(state - 1);
+         info.age = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::nanoseconds(now - startTime));
+         info.queuePosition = info.state == DialogState::Open || ticket < serving
+            ? 0 : static_cast<std::size_t>(ticket - serving);
+         return true;
       }
+
+      return false;
    }
 
-   GtkButtonsType getButtonsType(Buttons buttons)
+   /*!
+    * Counts the message boxes in the given state, leaving out those of 'exceptThread' (unless it is 0)
+    */
+   std::size_t countDialogs(DialogState state, unsigned long exceptThread = 0)
    {
-      switch (buttons)
+      std::int64_t now = nowNanoseconds();
+      DialogInfo info;
+      std::size_t count = 0;
+      for (const DialogSlot& slot : dialogSlots)
       {
-      case Buttons::OK:
-         return GTK_BUTTONS_OK;
-      case Buttons::OKCancel:
-         return GTK_BUTTONS_OK_CANCEL;
-      case Buttons::YesNo:
-         return GTK_BUTTONS_YES_NO;
-     case Buttons::Quit:
-         return GTK_BUTTONS_CLOSE;
-      default:
-         return GTK_BUTTONS_OK;
+         if (readDialogSlot(slot, info, now) && info.state == state
+            && (exceptThread == 0 || info.threadId != exceptThread))
+         {
+            ++count;
+         }
       }
+      return count;
    }
 
-   Selection getSelection(gint response)
+#if defined(__linux__)
+   int dumpFileDescriptor = -1;
+
+   /*!
+    * Writes a buffer to a file descriptor using only async-signal-safe calls
+    */
+   void writeBuffer(int fd, const char* buffer, std::size_t length)
    {
-      switch (response)
+      while (length > 0)
       {
-      case GTK_RESPONSE_OK:
-         return Selection::OK;
-      case GTK_RESPONSE_CANCEL:
-         return Selection::Cancel;
-      case GTK_RESPONSE_YES:
-         return Selection::Yes;
-      case GTK_RESPONSE_NO:
-         return Selection::No;
-      case GTK_RESPONSE_CLOSE:
-         return Selection::Quit;
-      default:
-         return Selection::None;
+         ssize_t written = write(fd, buffer, length);
+         if (written <= 0)
+         {
+            return;
+         }
+         buffer += written;
+         length -= static_cast<std::size_t>(written);
       }
    }
-#elif defined(WINDOWS)
- #if defined(UNICODE)
-   bool utf8ToUtf16(const char* utf8String, std::wstring& utf16String)
+
+   void writeString(int fd, const char* string)
    {
-      int count = MultiByteToWideChar(CP_UTF8, 0, utf8String, -1, nullptr, 0);
-      if (count <= 0)
+      std::size_t length = 0;
+      while (string[length] != '\0')
       {
-         return false;
+         ++length;
       }
 
-      utf16String = std::wstring(static_cast<size_t>(count), L'\0');
-      return MultiByteToWideChar(CP_UTF8, 0, utf8String, -1, &utf16String[0], count) > 0;
+      writeBuffer(fd, string, length);
    }
- #endif // defined(UNICODE)
 
-   UINT getIcon(Style style)
+   void writeNumber(int fd, unsigned long long number)
+   {
+      char buffer[24];
+      char* end = buffer + sizeof(buffer) - 1;
+      char* begin = end;
+      *end = '\0';
+      do
+      {
+         *--begin = static_cast<char>('0' + number % 10);
+         number /= 10;
+      } while (number > 0);
+      writeString(fd, begin);
+   }
+
+   const char* getStyleName(Style style)
    {
       switch (style)
       {
       case Style::Info:
-         return MB_ICONINFORMATION;
+         return "Info";
       case Style::Warning:
-         return MB_ICONWARNING;
+         return "Warning";
       case Style::Error:
-         return MB_ICONERROR;
+         return "Error";
       case Style::Question:
-         return MB_ICONQUESTION;
+         return "Question";
       default:
-         return MB_ICONINFORMATION;
+         return "Unknown";
       }
    }
 
-   UINT getButtons(Buttons buttons)
+   void dumpDialogs(int)
    {
-      switch (buttons)
+      // write() may fail and set errno, which belongs to the code this handler interrupted
+      int savedErrno = errno;
+      int fd = dumpFileDescriptor;
+      std::int64_t now = nowNanoseconds();
+      DialogInfo info;
+      for (const DialogSlot& slot : dialogSlots)
       {
-      case Buttons::OK:
-      case Buttons::Quit: // There is no 'Quit' button on Windows :(
-         return MB_OK;
-      case Buttons::OKCancel:
-         return MB_OKCANCEL;
-      case Buttons::YesNo:
-         return MB_YESNO;
-      default:
-         return MB_OK;
-      }
-   }
+         if (!readDialogSlot(slot, info, now))
+         {
+            continue;
+         }
 
-   Selection getSelection(int response, Buttons buttons)
-   {
-      switch (response)
-      {
-      case IDOK:
-         return buttons == Buttons::Quit ? Selection::Quit : Selection::OK;
-      case IDCANCEL:
-         return Selection::Cancel;
-      case IDYES:
-         return Selection::Yes;
-      case IDNO:
-         return Selection::No;
-      default:
-         return Selection::None;
+         writeString(fd, info.state == DialogState::Open ? "boxer: open" : "boxer: pending");
+         writeString(fd, " thread=");
+         writeNumber(fd, info.threadId);
+         writeString(fd, " age=");
+         writeNumber(fd, static_cast<unsigned long long>(info.age.count()));
+         writeString(fd, "ms queue=");
+         writeNumber(fd, info.queuePosition);
+         writeString(fd, " style=");
+         writeString(fd, getStyleName(info.style));
+         writeString(fd, " title=\"");
+         writeString(fd, info.title);
+         writeString(fd, "\"\n");
       }
+      errno = savedErrno;
    }
-#endif // defined(__linux__/WINDOWS)
-} // namespace
-
-/*!
- * The default style to apply to a message box
- */
-constexpr Style kDefaultStyle = Style::Info;
+#endif // defined(__linux__)
 
-/*!
- * The default buttons to provide on a message box
- */
-constexpr Buttons kDefaultButtons = Buttons::OK;
+   std::atomic<int> memoryPressure(static_cast<int>(MemoryPressure::Unknown));
+   std::atomic<std::uint64_t> memoryPressureTriggers;
+   std::atomic<std::uint64_t> memoryPressureFallbacks;
 
-/*!
- * Blocking call to create a modal message box with the given message, title, style, and buttons
- */
-BOXERAPI Selection show(const char* message, const char* title, Style style, Buttons buttons)
-{
 #if defined(__linux__)
-   if (!gtk_init_check(0, nullptr))
+   /*!
+    * Each watcher gets a generation, so that a watcher that is still winding down after being stopped can not
+    * overwrite the state of its successor
+    */
+   std::mutex memoryPressureMutex;
+   unsigned int memoryPressureGeneration = 0;
+   int memoryPressureStopDescriptor = -1;
+
+   void setMemoryPressure(unsigned int generation, MemoryPressure pressure)
    {
-      return Selection::Error;
+      std::lock_guard<std::mutex> lock(memoryPressureMutex);
+      if (generation == memoryPressureGeneration)
+      {
+         memoryPressure.store(static_cast<int>(pressure), std::memory_order_relaxed);
+      }
    }
 
-   // Create a parent window to stop gtk_dialog_run from complaining
-   GtkWidget* parent = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+   /*!
+    * Blocks on the PSI trigger until it fires or the watcher is stopped. While the pressure is high, the poll times out
+    * after the hold time, so the pressure is only considered cleared once no stall has been reported for that long.
+    * Owns both file descriptors.
+    */
+   void watchMemoryPressureTrigger(int triggerDescriptor, int stopDescriptor, int holdMilliseconds, unsigned int generation)
+   {
+      pollfd descriptors[2] = { { triggerDescriptor, POLLPRI, 0 }, { stopDescriptor, POLLIN, 0 } };
+      bool high = false;
+      for (;;)
+      {
+         int ready = poll(descriptors, 2, high ? holdMilliseconds : -1);
+         if (ready < 0)
+         {
+            if (errno == EINTR)
+            {
+               continue;
+            }
+            break;
+         }
 
-   GtkWidget* dialog = gtk_message_dialog_new(GTK_WINDOW(parent),
-                                              GTK_DIALOG_MODAL,
-                                              getMessageType(style),
-                                              getButtonsType(buttons),
-                                              "%s",
-                                              message);
-   gtk_window_set_title(GTK_WINDOW(dialog), title);
+         if (ready == 0)
+         {
+            high = false;
+            setMemoryPressure(generation, MemoryPressure::Normal);
+            continue;
+         }
 
-   gtk_window_set_gravity(GTK_WINDOW(parent), GDK_GRAVITY_CENTER);
-   gtk_window_set_gravity(GTK_WINDOW(dialog), GDK_GRAVITY_CENTER);
-   gtk_window_set_position(GTK_WINDOW(parent), GTK_WIN_POS_CENTER);
-   gtk_window_set_position(GTK_WINDOW(dialog), GTK_WIN_POS_CENTER);
+         // Closing the other end of the pipe stops the watcher. An error on the trigger means that the watched cgroup
+         // has been removed.
+         if (descriptors[1].revents != 0 || (descriptors[0].revents & (POLLERR | POLLNVAL)) != 0)
+         {
+            break;
+         }
 
-   Selection selection = getSelection(gtk_dialog_run(GTK_DIALOG(dialog)));
+         if ((descriptors[0].revents & POLLPRI) != 0)
+         {
+            high = true;
+            memoryPressureTriggers.fetch_add(1, std::memory_order_relaxed);
+            setMemoryPressure(generation, MemoryPressure::High);
+         }
+      }
 
-   gtk_widget_destroy(GTK_WIDGET(dialog));
-   gtk_widget_destroy(GTK_WIDGET(parent));
-   while (g_main_context_iteration(nullptr, false));
+      setMemoryPressure(generation, MemoryPressure::Unknown);
+      close(triggerDescriptor);
+      close(stopDescriptor);
+   }
 
-   return selection;
-#elif defined(WINDOWS)
-   UINT flags = MB_TASKMODAL;
+   /*!
+    * A key that can be typed on a terminal to answer a message box
+    */
+   struct TerminalChoice
+   {
+      char key;
+      Selection selection;
+   };
 
-   flags |= getIcon(style);
-   flags |= getButtons(buttons);
+   /*!
+    * Asks on the controlling terminal, without touching the heap or a toolkit. Returns 'None' if stdin is closed.
+    */
+   Selection promptOnTerminal(const char* message,
+                              std::size_t messageLength,
+                              const char* title,
+                              std::size_t titleLength,
+                              Style style,
+                              Buttons buttons)
+   {
+      const char* prompt = "[o]k: ";
+      TerminalChoice choices[4] = { { 'o', Selection::OK },
+                                    { '\0', Selection::None },
+                                    { '\0', Selection::None },
+                                    { '\0', Selection::None } };
+      switch (buttons)
+      {
+      case Buttons::OKCancel:
+         prompt = "[o]k / [c]ancel: ";
+         choices[1] = { 'c', Selection::Cancel };
+         break;
+      case Buttons::YesNo:
+         prompt = "[y]es / [n]o: ";
+         choices[0] = { 'y', Selection::Yes };
+         choices[1] = { 'n', Selection::No };
+         break;
+      case Buttons::Quit:
+         prompt = "[q]uit: ";
+         choices[0] = { 'q', Selection::Quit };
+         break;
+      case Buttons::AbortRetryIgnore:
+         prompt = "[a]bort / [r]etry / [i]gnore / i[g]nore always: ";
+         choices[0] = { 'a', Selection::Abort };
+         choices[1] = { 'r', Selection::Retry };
+         choices[2] = { 'i', Selection::Ignore };
+         choices[3] = { 'g', Selection::IgnoreAlways };
+         break;
+      default:
+         break;
+      }
+
+      writeString(STDERR_FILENO, "\n[");
+      writeString(STDERR_FILENO, getStyleName(style));
+      writeString(STDERR_FILENO, "] ");
+      writeBuffer(STDERR_FILENO, title, titleLength);
+      writeString(STDERR_FILENO, "\n");
+      writeBuffer(STDERR_FILENO, message, messageLength);
+      writeString(STDERR_FILENO, "\n");
+
+      for (;;)
+      {
+         writeString(STDERR_FILENO, prompt);
+
+         // Only the first character of the line matters, the rest is read and dropped
+         char key = '\0';
+         char character = '\0';
+         ssize_t count = 0;
+         while ((count = read(STDIN_FILENO, &character, 1)) == 1 && character != '\n')
+         {
+            if (key == '\0' && character != ' ' && character != '\t')
+            {
+               key = static_cast<char>(character >= 'A' && character <= 'Z' ? character - 'A' + 'a' : character);
+            }
+         }
+
+         for (const TerminalChoice& choice : choices)
+         {
+            if (choice.key != '\0' && choice.key == key)
+            {
+               return choice.selection;
+            }
+         }
+
+         if (count <= 0)
+         {
+            return Selection::None;
+         }
+      }
+   }
+
+   /*!
+    * Shows a message box on the terminal if there is one, and otherwise only logs it to stderr
+    */
+   Selection showWithoutToolkit(const char* message,
+                                std::size_t messageLength,
+                                const char* title,
+                                std::size_t titleLength,
+                                Style style,
+                                Buttons buttons)
+   {
+      memoryPressureFallbacks.fetch_add(1, std::memory_order_relaxed);
+      if (isatty(STDIN_FILENO) && isatty(STDERR_FILENO))
+      {
+         return promptOnTerminal(message, messageLength, title, titleLength, style, buttons);
+      }
+
+      writeString(STDERR_FILENO, "boxer: [");
+      writeString(STDERR_FILENO, getStyleName(style));
+      writeString(STDERR_FILENO, "] ");
+      writeBuffer(STDERR_FILENO, title, titleLength);
+      writeString(STDERR_FILENO, ": ");
+      writeBuffer(STDERR_FILENO, message, messageLength);
+      writeString(STDERR_FILENO, "\n");
+      return Selection::None;
+   }
+#endif // defined(__linux__)
+
+   std::mutex escalationMutex;
+   EscalationPolicy escalationPolicies[4];
+   std::atomic<std::uint64_t> escalationsRaised;
+   std::atomic<std::uint64_t> escalationsNotified;
+   std::atomic<std::uint64_t> escalationsResolved;
+
+   /*!
+    * The escalation of a single message box. Each backend runs the stages from timers on its own event loop, so
+    * nothing is polled while the message box is open.
+    */
+   struct Escalation
+   {
+      Escalation(const char* message,
+                 std::size_t messageLength,
+                 const char* title,
+                 std::size_t titleLength,
+                 Style style)
+         : message(message), messageLength(messageLength), title(title), titleLength(titleLength), style(style)
+      {
+         std::lock_guard<std::mutex> lock(escalationMutex);
+         policy = escalationPolicies[static_cast<std::size_t>(style)];
+      }
+
+      void notify() const
+      {
+         escalationsNotified.fetch_add(1, std::memory_order_relaxed);
+         if (policy.notify)
+         {
+            // The strings may be slices of larger buffers, so they are only terminated once they are actually needed
+            std::string terminatedMessage(message, messageLength);
+            std::string terminatedTitle(title, titleLength);
+            policy.notify(terminatedMessage.c_str(), terminatedTitle.c_str(), style);
+         }
+      }
+
+      EscalationPolicy policy;
+      const char* message;
+      std::size_t messageLength;
+      const char* title;
+      std::size_t titleLength;
+      Style style;
+   };
+
+   /*!
+    * A null-terminated copy of a string that reuses a per-thread buffer, for the APIs that require a terminator. Each
+    * slot holds one buffer per thread. A nested use of the same slot (e.g. from a callback of an open message box)
+    * finds the buffer taken and falls back to a buffer of its own.
+    */
+   template <int Slot>
+   class ScratchString
+   {
+   public:
+      ScratchString(const char* data, std::size_t size)
+      {
+         value.swap(buffer());
+         value.assign(data, size);
+      }
+
+      ~ScratchString()
+      {
+         value.swap(buffer());
+      }
+
+      ScratchString(const ScratchString&) = delete;
+      ScratchString& operator=(const ScratchString&) = delete;
+
+      const char* c_str() const
+      {
+         return value.c_str();
+      }
+
+   private:
+      static std::string& buffer()
+      {
+         static thread_local std::string scratch;
+         return scratch;
+      }
+
+      std::string value;
+   };
+
+   using ScratchTitle = ScratchString<0>;
+   using ScratchMessage = ScratchString<1>;
+
+   /*!
+    * Compares two rows of 32-bit pixels, allowing each channel to differ by up to 'tolerance'
+    */
+   bool pixelsMatch(const unsigned char* row, const unsigned char* goldenRow, std::size_t pixels, unsigned int tolerance)
+   {
+      for (std::size_t i = 0; i < pixels * 4; ++i)
+      {
+         unsigned int difference = row[i] > goldenRow[i] ? row[i] - goldenRow[i] : goldenRow[i] - row[i];
+         if (difference > tolerance)
+         {
+            return false;
+         }
+      }
+      return true;
+   }
+
+#if defined(BOXER_ENABLE_ALLOCATION_STATS)
+ #if defined(__GNUC__)
+  // The interposed allocators may run before the thread's dynamic TLS is set up, which must not itself allocate
+  #define BOXER_ALLOCATION_TLS __attribute__((tls_model("initial-exec")))
+ #else // defined(__GNUC__)
+  #define BOXER_ALLOCATION_TLS
+ #endif // defined(__GNUC__)
+
+   struct AllocationCounters
+   {
+      bool active;
+      std::size_t newAllocations;
+      std::size_t newBytes;
+      std::size_t mallocAllocations;
+      std::size_t mallocBytes;
+   };
+
+   thread_local AllocationCounters allocationCounters BOXER_ALLOCATION_TLS = {};
+   thread_local AllocationStats lastAllocationStats BOXER_ALLOCATION_TLS = {};
+
+   /*!
+    * Counts the allocations made on the calling thread for as long as it is in scope, and records them as the stats
+    * of the last message box when it goes out of scope. Nested scopes are folded into the outermost one.
+    */
+   class AllocationScope
+   {
+   public:
+      AllocationScope()
+         : outermost(!allocationCounters.active)
+      {
+         if (outermost)
+         {
+            allocationCounters = {};
+            allocationCounters.active = true;
+         }
+      }
+
+      ~AllocationScope()
+      {
+         if (!outermost)
+         {
+            return;
+         }
+
+         allocationCounters.active = false;
+
+         // operator new is implemented on top of malloc, so its allocations show up in both counters
+         lastAllocationStats.boxerAllocations = allocationCounters.newAllocations;
+         lastAllocationStats.boxerBytes = allocationCounters.newBytes;
+         lastAllocationStats.toolkitAllocations = allocationCounters.mallocAllocations > allocationCounters.newAllocations
+            ? allocationCounters.mallocAllocations - allocationCounters.newAllocations : 0;
+         lastAllocationStats.toolkitBytes = allocationCounters.mallocBytes > allocationCounters.newBytes
+            ? allocationCounters.mallocBytes - allocationCounters.newBytes : 0;
+      }
+
+      AllocationScope(const AllocationScope&) = delete;
+      AllocationScope& operator=(const AllocationScope&) = delete;
+
+   private:
+      bool outermost;
+   };
+
+   void countNew(std::size_t size)
+   {
+      if (allocationCounters.active)
+      {
+         ++allocationCounters.newAllocations;
+         allocationCounters.newBytes += size;
+      }
+   }
+
+   void countMalloc(std::size_t size)
+   {
+      if (allocationCounters.active)
+      {
+         ++allocationCounters.mallocAllocations;
+         allocationCounters.mallocBytes += size;
+      }
+   }
+
+ #define BOXER_COUNT_ALLOCATIONS() AllocationScope allocationScope
+#else // defined(BOXER_ENABLE_ALLOCATION_STATS)
+ #define BOXER_COUNT_ALLOCATIONS() static_cast<void>(0)
+#endif // defined(BOXER_ENABLE_ALLOCATION_STATS)
+
+#if defined(BOXER_BACKEND_QT)
+   /*!
+    * Returns the running QApplication, creating a minimal one if there is none yet. Returns nullptr if the running
+    * application is not a QApplication (e.g. a QCoreApplication), or if it is called from a thread other than the
+    * application's GUI thread, in both of which cases no widgets can be shown.
+    */
+   QApplication* getApplication()
+   {
+      QApplication* application = nullptr;
+      if (QCoreApplication::instance())
+      {
+         application = qobject_cast<QApplication*>(QCoreApplication::instance());
+      }
+      else
+      {
+         static int argc = 1;
+         static char name[] = "boxer";
+         static char* argv[] = { name, nullptr };
+         static QApplication minimalApplication(argc, argv);
+         application = &minimalApplication;
+      }
+
+      // Widgets may only be created and used on the GUI thread
+      return application && QThread::currentThread() == application->thread() ? application : nullptr;
+   }
+
+   QMessageBox::Icon getIcon(Style style)
+   {
+      switch (style)
+      {
+      case Style::Info:
+         return QMessageBox::Information;
+      case Style::Warning:
+         return QMessageBox::Warning;
+      case Style::Error:
+         return QMessageBox::Critical;
+      case Style::Question:
+         return QMessageBox::Question;
+      default:
+         return QMessageBox::Information;
+      }
+   }
+
+   QMessageBox::StandardButtons getStandardButtons(Buttons buttons)
+   {
+      switch (buttons)
+      {
+      case Buttons::OK:
+         return QMessageBox::Ok;
+      case Buttons::OKCancel:
+         return QMessageBox::Ok | QMessageBox::Cancel;
+      case Buttons::YesNo:
+         return QMessageBox::Yes | QMessageBox::No;
+      case Buttons::Quit:
+         return QMessageBox::Close;
+      case Buttons::AbortRetryIgnore:
+         return QMessageBox::Abort | QMessageBox::Retry | QMessageBox::Ignore;
+      default:
+         return QMessageBox::Ok;
+      }
+   }
+
+   /*!
+    * Sets the buttons of a message box. 'Ignore Always' is the only button that is not a standard button.
+    */
+   void setButtons(QMessageBox& box, Buttons buttons)
+   {
+      for (QAbstractButton* button : box.buttons())
+      {
+         if (box.standardButton(button) == QMessageBox::NoButton)
+         {
+            box.removeButton(button);
+            delete button;
+         }
+      }
+
+      box.setStandardButtons(getStandardButtons(buttons));
+      if (buttons == Buttons::AbortRetryIgnore)
+      {
+         box.addButton(QMessageBox::tr("Ignore Always"), QMessageBox::AcceptRole);
+      }
+   }
+
+   QAbstractButton* getIgnoreAlwaysButton(const QMessageBox& box)
+   {
+      for (QAbstractButton* button : box.buttons())
+      {
+         if (box.standardButton(button) == QMessageBox::NoButton)
+         {
+            return button;
+         }
+      }
+      return nullptr;
+   }
+
+   Selection getSelection(int response)
+   {
+      switch (response)
+      {
+      case QMessageBox::Ok:
+         return Selection::OK;
+      case QMessageBox::Cancel:
+         return Selection::Cancel;
+      case QMessageBox::Yes:
+         return Selection::Yes;
+      case QMessageBox::No:
+         return Selection::No;
+      case QMessageBox::Close:
+         return Selection::Quit;
+      case QMessageBox::Abort:
+         return Selection::Abort;
+      case QMessageBox::Retry:
+         return Selection::Retry;
+      case QMessageBox::Ignore:
+         return Selection::Ignore;
+      default:
+         return Selection::None;
+      }
+   }
+
+   Selection getSelection(const QMessageBox& box, int response)
+   {
+      if (box.clickedButton() && box.clickedButton() == getIgnoreAlwaysButton(box))
+      {
+         return Selection::IgnoreAlways;
+      }
+      return getSelection(response);
+   }
+
+   QMessageBox::StandardButton getStandardButton(Selection selection)
+   {
+      switch (selection)
+      {
+      case Selection::OK:
+         return QMessageBox::Ok;
+      case Selection::Cancel:
+         return QMessageBox::Cancel;
+      case Selection::Yes:
+         return QMessageBox::Yes;
+      case Selection::No:
+         return QMessageBox::No;
+      case Selection::Quit:
+         return QMessageBox::Close;
+      case Selection::Abort:
+         return QMessageBox::Abort;
+      case Selection::Retry:
+         return QMessageBox::Retry;
+      case Selection::Ignore:
+         return QMessageBox::Ignore;
+      default:
+         return QMessageBox::NoButton;
+      }
+   }
+
+   /*!
+    * Answers a message box with the given selection, as if the user had clicked the corresponding button
+    */
+   void respond(QMessageBox& box, Selection selection)
+   {
+      QAbstractButton* button = selection == Selection::IgnoreAlways
+         ? getIgnoreAlwaysButton(box) : box.button(getStandardButton(selection));
+      if (button)
+      {
+         button->click();
+      }
+      else
+      {
+         box.done(QMessageBox::NoButton);
+      }
+   }
+
+   /*!
+    * Runs a function once after the given delay, unless the timer is destroyed first. Does nothing if the delay is
+    * zero.
+    */
+   template <typename Function>
+   void startTimer(QTimer& timer, std::chrono::milliseconds delay, Function function)
+   {
+      if (delay.count() <= 0)
+      {
+         return;
+      }
+
+      timer.setSingleShot(true);
+      QObject::connect(&timer, &QTimer::timeout, function);
+      timer.start(static_cast<int>(delay.count()));
+   }
+
+ #if defined(BOXER_ENABLE_TEST_HOOKS)
+   /*!
+    * The response to emit into every message box, set through injectSelection()
+    */
+   struct InjectedSelection
+   {
+      bool enabled = false;
+      Selection selection = Selection::None;
+      unsigned int delayMilliseconds = 0;
+   } injectedSelection;
+ #endif // defined(BOXER_ENABLE_TEST_HOOKS)
+
+   /*!
+    * A message box that stays mapped once it is answered, so that the next step of a Flow updates the same window
+    * instead of hiding it and showing it again. Answering it only ends the event loop of run().
+    */
+   class PersistentMessageBox : public QMessageBox
+   {
+   public:
+      /*!
+       * Shows the message box unless it is already shown, and waits for a response in a local event loop
+       */
+      int run()
+      {
+         setWindowModality(Qt::ApplicationModal);
+         if (!isVisible())
+         {
+            show();
+         }
+
+         QEventLoop loop;
+         QEventLoop* previous = activeLoop;
+         activeLoop = &loop;
+         int result = loop.exec(QEventLoop::DialogExec);
+         activeLoop = previous;
+         return result;
+      }
+
+      void done(int result) override
+      {
+         setResult(result);
+         if (activeLoop)
+         {
+            activeLoop->exit(result);
+         }
+      }
+
+   private:
+      QEventLoop* activeLoop = nullptr;
+   };
+
+   int execDialog(QMessageBox& box)
+   {
+      return box.exec();
+   }
+
+   int execDialog(PersistentMessageBox& box)
+   {
+      return box.run();
+   }
+
+   /*!
+    * A message box run by runDialog(). Open message boxes form a stack, as one may be shown from a callback run by
+    * another one's event loop. Only accessed from the application's thread.
+    */
+   struct OpenBox
+   {
+      QMessageBox* box;
+      OpenBox* previous;
+   };
+
+   OpenBox* openBoxes = nullptr;
+
+   /*!
+    * Answers every open message box with 'shutdownSelection'. Each one closes once its event loop gets to run again.
+    */
+   void answerOpenBoxes()
+   {
+      Selection selection = static_cast<Selection>(shutdownSelection.load(std::memory_order_relaxed));
+      for (OpenBox* open = openBoxes; open; open = open->previous)
+      {
+         respond(*open->box, selection);
+      }
+   }
+
+   /*!
+    * Answers the open message boxes with 'shutdownSelection'. Thread-safe. Called on the application's thread (e.g.
+    * from a slot run by an open message box's event loop), they are answered right away, as an event posted to that
+    * thread would only run once the caller returns.
+    */
+   void closeOpenDialogs()
+   {
+      if (QCoreApplication* application = QCoreApplication::instance())
+      {
+         if (QThread::currentThread() == application->thread())
+         {
+            answerOpenBoxes();
+         }
+         else
+         {
+            QTimer::singleShot(0, application, []()
+            {
+               answerOpenBoxes();
+            });
+         }
+      }
+   }
+
+   /*!
+    * Runs a message box until it receives a response. All message boxes go through here so that hooks apply to each
+    * of them in the same way.
+    */
+   template <typename Box>
+   int runDialog(Box& box,
+                 const char* message,
+                 std::size_t messageLength,
+                 const char* title,
+                 std::size_t titleLength,
+                 Style style)
+   {
+      // The timers are owned by this call, so none of them can fire into a later step of a Flow reusing the box
+      Escalation escalation(message, messageLength, title, titleLength, style);
+      QTimer raiseTimer;
+      QTimer notifyTimer;
+      QTimer resolveTimer;
+
+      startTimer(raiseTimer, escalation.policy.raiseAfter, [&box]()
+      {
+         escalationsRaised.fetch_add(1, std::memory_order_relaxed);
+         box.show();
+         box.raise();
+         box.activateWindow();
+         QApplication::alert(&box);
+      });
+      startTimer(notifyTimer, escalation.policy.notifyAfter, [&escalation]()
+      {
+         escalation.notify();
+      });
+      startTimer(resolveTimer, escalation.policy.resolveAfter, [&box, &escalation]()
+      {
+         escalationsResolved.fetch_add(1, std::memory_order_relaxed);
+         respond(box, escalation.policy.resolution);
+      });
+
+ #if defined(BOXER_ENABLE_TEST_HOOKS)
+      QTimer injectionTimer;
+      if (injectedSelection.enabled)
+      {
+         Selection selection = injectedSelection.selection;
+         std::chrono::milliseconds delay(injectedSelection.delayMilliseconds);
+
+         // The message box is shown before events are processed, so the delay starts once it is shown
+         QTimer::singleShot(0, &injectionTimer, [&box, &injectionTimer, selection, delay]()
+         {
+            startTimer(injectionTimer, delay.count() > 0 ? delay : std::chrono::milliseconds(1), [&box, selection]()
+            {
+               respond(box, selection);
+            });
+         });
+      }
+ #endif // defined(BOXER_ENABLE_TEST_HOOKS)
+
+      OpenBox open = { &box, openBoxes };
+      openBoxes = &open;
+      int result = execDialog(box);
+      openBoxes = open.previous;
+      return result;
+   }
+#elif defined(BOXER_BACKEND_GTK)
+   std::atomic<int> roundTripMode(static_cast<int>(RoundTripMode::Auto));
+
+   /*!
+    * Whether DISPLAY names an X11 display on another host, e.g. 'localhost:10.0' as set up by SSH X forwarding, rather
+    * than a local one like ':0' or 'unix:0'
+    */
+   bool isRemoteDisplay()
+   {
+      const char* display = getenv("DISPLAY");
+      if (!display || getenv("WAYLAND_DISPLAY"))
+      {
+         return false;
+      }
+
+      const char* colon = strrchr(display, ':');
+      std::size_t hostLength = colon ? static_cast<std::size_t>(colon - display) : 0;
+      return hostLength > 0 && !(hostLength == 4 && strncmp(display, "unix", 4) == 0) && display[0] != '/';
+   }
+
+   bool useMinimalRoundTrips()
+   {
+      switch (static_cast<RoundTripMode>(roundTripMode.load(std::memory_order_relaxed)))
+      {
+      case RoundTripMode::Minimal:
+         return true;
+      case RoundTripMode::Standard:
+         return false;
+      default:
+      {
+         static const bool remote = isRemoteDisplay();
+         return remote;
+      }
+      }
+   }
+
+   bool initGtk()
+   {
+      static bool initialized = false;
+      if (initialized || !useMinimalRoundTrips())
+      {
+         initialized = gtk_init_check(0, nullptr);
+         return initialized;
+      }
+
+      // Skip enumerating XInput2 devices, which costs synchronous round-trips during initialization. The lookup of the
+      // accessibility bus is left to NO_AT_BRIDGE, as setting it here could race with getenv() on other threads.
+      gdk_disable_multidevice();
+
+      initialized = gtk_init_check(0, nullptr);
+      return initialized;
+   }
+
+   /*!
+    * Centers a message box and its parent window on screen. This queries the monitor's work area and the window
+    * manager's frame extents when the windows are shown, so it is skipped when round-trips should be minimal, leaving
+    * the placement to the window manager.
+    */
+   void centerWindows(GtkWidget* parent, GtkWidget* dialog)
+   {
+      if (useMinimalRoundTrips())
+      {
+         return;
+      }
+
+      gtk_window_set_gravity(GTK_WINDOW(parent), GDK_GRAVITY_CENTER);
+      gtk_window_set_gravity(GTK_WINDOW(dialog), GDK_GRAVITY_CENTER);
+      gtk_window_set_position(GTK_WINDOW(parent), GTK_WIN_POS_CENTER);
+      gtk_window_set_position(GTK_WINDOW(dialog), GTK_WIN_POS_CENTER);
+   }
+
+   GtkMessageType getMessageType(Style style)
+   {
+      switch (style)
+      {
+      case Style::Info:
+         return GTK_MESSAGE_INFO;
+      case Style::Warning:
+         return GTK_MESSAGE_WARNING;
+      case Style::Error:
+         return GTK_MESSAGE_ERROR;
+      case Style::Question:
+         return GTK_MESSAGE_QUESTION;
+      default:
+         return GTK_MESSAGE_INFO;
+      }
+   }
+
+   GtkButtonsType getButtonsType(Buttons buttons)
+   {
+      switch (buttons)
+      {
+      case Buttons::OK:
+         return GTK_BUTTONS_OK;
+      case Buttons::OKCancel:
+         return GTK_BUTTONS_OK_CANCEL;
+      case Buttons::YesNo:
+         return GTK_BUTTONS_YES_NO;
+     case Buttons::Quit:
+         return GTK_BUTTONS_CLOSE;
+      case Buttons::AbortRetryIgnore: // There is no built-in set for these, they are added by addButtons()
+         return GTK_BUTTONS_NONE;
+      default:
+         return GTK_BUTTONS_OK;
+      }
+   }
+
+   /*!
+    * Responses of the buttons that GTK has no predefined response for
+    */
+   enum CustomResponse : gint
+   {
+      kResponseAbort = 1,
+      kResponseRetry,
+      kResponseIgnore,
+      kResponseIgnoreAlways
+   };
+
+   /*!
+    * Adds the buttons for the given option to a dialog that was created with GTK_BUTTONS_NONE, in the same order that
+    * GTK uses for its built-in button sets
+    */
+   void addButtons(GtkDialog* dialog, Buttons buttons)
+   {
+      switch (buttons)
+      {
+      case Buttons::OKCancel:
+         gtk_dialog_add_button(dialog, "_Cancel", GTK_RESPONSE_CANCEL);
+         gtk_dialog_add_button(dialog, "_OK", GTK_RESPONSE_OK);
+         break;
+      case Buttons::YesNo:
+         gtk_dialog_add_button(dialog, "_No", GTK_RESPONSE_NO);
+         gtk_dialog_add_button(dialog, "_Yes", GTK_RESPONSE_YES);
+         break;
+      case Buttons::Quit:
+         gtk_dialog_add_button(dialog, "_Close", GTK_RESPONSE_CLOSE);
+         break;
+      case Buttons::AbortRetryIgnore:
+         gtk_dialog_add_button(dialog, "_Abort", kResponseAbort);
+         gtk_dialog_add_button(dialog, "_Retry", kResponseRetry);
+         gtk_dialog_add_button(dialog, "_Ignore", kResponseIgnore);
+         gtk_dialog_add_button(dialog, "Ignore _Always", kResponseIgnoreAlways);
+         break;
+      case Buttons::OK:
+      default:
+         gtk_dialog_add_button(dialog, "_OK", GTK_RESPONSE_OK);
+         break;
+      }
+   }
+
+   /*!
+    * Removes any buttons previously added by addButtons()
+    */
+   void removeButtons(GtkDialog* dialog)
+   {
+      const gint responses[] = { GTK_RESPONSE_OK, GTK_RESPONSE_CANCEL, GTK_RESPONSE_YES, GTK_RESPONSE_NO, GTK_RESPONSE_CLOSE,
+                                 kResponseAbort, kResponseRetry, kResponseIgnore, kResponseIgnoreAlways };
+      for (gint response : responses)
+      {
+         if (GtkWidget* button = gtk_dialog_get_widget_for_response(dialog, response))
+         {
+            gtk_widget_destroy(button);
+         }
+      }
+   }
+
+   Selection getSelection(gint response)
+   {
+      switch (response)
+      {
+      case GTK_RESPONSE_OK:
+         return Selection::OK;
+      case GTK_RESPONSE_CANCEL:
+         return Selection::Cancel;
+      case GTK_RESPONSE_YES:
+         return Selection::Yes;
+      case GTK_RESPONSE_NO:
+         return Selection::No;
+      case GTK_RESPONSE_CLOSE:
+         return Selection::Quit;
+      case kResponseAbort:
+         return Selection::Abort;
+      case kResponseRetry:
+         return Selection::Retry;
+      case kResponseIgnore:
+         return Selection::Ignore;
+      case kResponseIgnoreAlways:
+         return Selection::IgnoreAlways;
+      default:
+         return Selection::None;
+      }
+   }
+
+   gint getResponse(Selection selection)
+   {
+      switch (selection)
+      {
+      case Selection::OK:
+         return GTK_RESPONSE_OK;
+      case Selection::Cancel:
+         return GTK_RESPONSE_CANCEL;
+      case Selection::Yes:
+         return GTK_RESPONSE_YES;
+      case Selection::No:
+         return GTK_RESPONSE_NO;
+      case Selection::Quit:
+         return GTK_RESPONSE_CLOSE;
+      case Selection::Abort:
+         return kResponseAbort;
+      case Selection::Retry:
+         return kResponseRetry;
+      case Selection::Ignore:
+         return kResponseIgnore;
+      case Selection::IgnoreAlways:
+         return kResponseIgnoreAlways;
+      default:
+         return GTK_RESPONSE_DELETE_EVENT;
+      }
+   }
+
+   /*!
+    * Answers a dialog with the given selection, as if the user had clicked the corresponding button. A dialog without
+    * that button is answered as if it had been closed, so that it gives 'None' rather than a button it does not have.
+    */
+   void respond(GtkDialog* dialog, Selection selection)
+   {
+      gint response = getResponse(selection);
+      if (!gtk_dialog_get_widget_for_response(dialog, response))
+      {
+         response = GTK_RESPONSE_DELETE_EVENT;
+      }
+      gtk_dialog_response(dialog, response);
+   }
+
+   struct EscalationContext
+   {
+      GtkDialog* dialog;
+      Escalation escalation;
+      guint raiseSource;
+      guint notifySource;
+      guint resolveSource;
+   };
+
+   gboolean raiseEscalation(gpointer data)
+   {
+      EscalationContext* context = static_cast<EscalationContext*>(data);
+      context->raiseSource = 0;
+      escalationsRaised.fetch_add(1, std::memory_order_relaxed);
+
+      gtk_window_set_keep_above(GTK_WINDOW(context->dialog), TRUE);
+      gtk_window_set_urgency_hint(GTK_WINDOW(context->dialog), TRUE);
+      gtk_window_present(GTK_WINDOW(context->dialog));
+      return G_SOURCE_REMOVE;
+   }
+
+   gboolean notifyEscalation(gpointer data)
+   {
+      EscalationContext* context = static_cast<EscalationContext*>(data);
+      context->notifySource = 0;
+      context->escalation.notify();
+      return G_SOURCE_REMOVE;
+   }
+
+   gboolean resolveEscalation(gpointer data)
+   {
+      EscalationContext* context = static_cast<EscalationContext*>(data);
+      context->resolveSource = 0;
+      escalationsResolved.fetch_add(1, std::memory_order_relaxed);
+
+      respond(context->dialog, context->escalation.policy.resolution);
+      return G_SOURCE_REMOVE;
+   }
+
+   guint addTimeout(std::chrono::milliseconds delay, GSourceFunc function, gpointer data)
+   {
+      return delay.count() > 0 ? g_timeout_add(static_cast<guint>(delay.count()), function, data) : 0;
+   }
+
+   void removeTimeout(guint source)
+   {
+      if (source)
+      {
+         g_source_remove(source);
+      }
+   }
+
+ #if defined(BOXER_ENABLE_TEST_HOOKS)
+   /*!
+    * The response to emit into every message box, set through injectSelection()
+    */
+   struct InjectedSelection
+   {
+      bool enabled = false;
+      Selection selection = Selection::None;
+      guint delayMilliseconds = 0;
+   } injectedSelection;
+
+   struct InjectionContext
+   {
+      GtkDialog* dialog;
+      gint response;
+      guint delayMilliseconds;
+      guint source;
+      bool scheduled;
+   };
+
+   gboolean emitInjectedResponse(gpointer data)
+   {
+      InjectionContext* context = static_cast<InjectionContext*>(data);
+      context->source = 0;
+      gtk_dialog_response(context->dialog, context->response);
+      return G_SOURCE_REMOVE;
+   }
+
+   void scheduleInjectedResponse(GtkWidget*, gpointer data)
+   {
+      InjectionContext* context = static_cast<InjectionContext*>(data);
+      if (!context->scheduled)
+      {
+         context->scheduled = true;
+         context->source = g_timeout_add(context->delayMilliseconds, emitInjectedResponse, context);
+      }
+   }
+ #endif // defined(BOXER_ENABLE_TEST_HOOKS)
+
+   /*!
+    * A dialog run by runDialog(). Open dialogs form a stack, as one may be shown from a callback run by another one's
+    * main loop. Only accessed from the thread iterating the main context.
+    */
+   struct OpenDialog
+   {
+      GtkDialog* dialog;
+      OpenDialog* previous;
+   };
+
+   OpenDialog* openDialogs = nullptr;
+
+   /*!
+    * Answers every open dialog with 'shutdownSelection'. Each one closes once its main loop gets to run again.
+    */
+   gboolean answerOpenDialogs(gpointer)
+   {
+      gint response = getResponse(static_cast<Selection>(shutdownSelection.load(std::memory_order_relaxed)));
+      for (OpenDialog* open = openDialogs; open; open = open->previous)
+      {
+         gtk_dialog_response(open->dialog, response);
+      }
+      return G_SOURCE_REMOVE;
+   }
+
+   /*!
+    * Answers the open dialogs with 'shutdownSelection'. Thread-safe. A caller that owns the main context (e.g. a GLib
+    * callback run by an open dialog's main loop) answers them right away, as an idle callback would only run once it
+    * returns.
+    */
+   void closeOpenDialogs()
+   {
+      if (g_main_context_is_owner(nullptr))
+      {
+         answerOpenDialogs(nullptr);
+      }
+      else
+      {
+         g_idle_add(answerOpenDialogs, &openDialogs);
+      }
+   }
+
+   /*!
+    * Answers the dialogs open on the thread passed as data with 'OK'. The main context is iterated by whichever thread
+    * has a dialog open, so this runs on a timer until that thread gets to it, and keeps running in case the thread
+    * shows another dialog.
+    */
+   gboolean answerThreadDialogs(gpointer thread)
+   {
+      if (getThreadId() == static_cast<unsigned long>(reinterpret_cast<std::uintptr_t>(thread)))
+      {
+         for (OpenDialog* open = openDialogs; open; open = open->previous)
+         {
+            respond(open->dialog, Selection::OK);
+         }
+      }
+      return G_SOURCE_CONTINUE;
+   }
+
+   /*!
+    * Runs a dialog until it receives a response. All message boxes go through here so that hooks apply to each of
+    * them in the same way.
+    */
+   gint runDialog(GtkDialog* dialog,
+                  const char* message,
+                  std::size_t messageLength,
+                  const char* title,
+                  std::size_t titleLength,
+                  Style style)
+   {
+      EscalationContext escalation = { dialog, Escalation(message, messageLength, title, titleLength, style), 0, 0, 0 };
+      escalation.raiseSource = addTimeout(escalation.escalation.policy.raiseAfter, raiseEscalation, &escalation);
+      escalation.notifySource = addTimeout(escalation.escalation.policy.notifyAfter, notifyEscalation, &escalation);
+      escalation.resolveSource = addTimeout(escalation.escalation.policy.resolveAfter, resolveEscalation, &escalation);
+
+ #if defined(BOXER_ENABLE_TEST_HOOKS)
+      InjectionContext context = { dialog, 0, 0, 0, false };
+      gulong mapHandler = 0;
+      if (injectedSelection.enabled)
+      {
+         context.response = getResponse(injectedSelection.selection);
+         context.delayMilliseconds = injectedSelection.delayMilliseconds;
+
+         // A dialog reused by a Flow is already mapped, so there will be no further 'map' signal to wait for
+         if (gtk_widget_get_mapped(GTK_WIDGET(dialog)))
+         {
+            scheduleInjectedResponse(GTK_WIDGET(dialog), &context);
+         }
+         else
+         {
+            mapHandler = g_signal_connect(dialog, "map", G_CALLBACK(scheduleInjectedResponse), &context);
+         }
+      }
+
+      OpenDialog open = { dialog, openDialogs };
+      openDialogs = &open;
+      gint response = gtk_dialog_run(dialog);
+      openDialogs = open.previous;
+
+      if (mapHandler)
+      {
+         g_signal_handler_disconnect(dialog, mapHandler);
+      }
+      removeTimeout(context.source);
+ #else // defined(BOXER_ENABLE_TEST_HOOKS)
+      OpenDialog open = { dialog, openDialogs };
+      openDialogs = &open;
+      gint response = gtk_dialog_run(dialog);
+      openDialogs = open.previous;
+ #endif // defined(BOXER_ENABLE_TEST_HOOKS)
+
+      bool raised = escalation.escalation.policy.raiseAfter.count() > 0 && escalation.raiseSource == 0;
+      removeTimeout(escalation.raiseSource);
+      removeTimeout(escalation.notifySource);
+      removeTimeout(escalation.resolveSource);
+
+      // A dialog reused by a Flow should not stay highlighted in its next step
+      if (raised)
+      {
+         gtk_window_set_keep_above(GTK_WINDOW(dialog), FALSE);
+         gtk_window_set_urgency_hint(GTK_WINDOW(dialog), FALSE);
+      }
+
+      return response;
+   }
+#elif defined(BOXER_BACKEND_WIN32)
+ #if defined(UNICODE)
+   /*!
+    * Converts a string of the given length, which does not need to be null-terminated
+    */
+   bool utf8ToUtf16(const char* utf8String, std::size_t length, std::wstring& utf16String)
+   {
+      if (length == 0)
+      {
+         utf16String.clear();
+         return true;
+      }
+
+      int count = MultiByteToWideChar(CP_UTF8, 0, utf8String, static_cast<int>(length), nullptr, 0);
+      if (count <= 0)
+      {
+         return false;
+      }
+
+      utf16String.assign(static_cast<size_t>(count), L'\0');
+      return MultiByteToWideChar(CP_UTF8, 0, utf8String, static_cast<int>(length), &utf16String[0], count) > 0;
+   }
+ #endif // defined(UNICODE)
+
+   UINT getIcon(Style style)
+   {
+      switch (style)
+      {
+      case Style::Info:
+         return MB_ICONINFORMATION;
+      case Style::Warning:
+         return MB_ICONWARNING;
+      case Style::Error:
+         return MB_ICONERROR;
+      case Style::Question:
+         return MB_ICONQUESTION;
+      default:
+         return MB_ICONINFORMATION;
+      }
+   }
+
+   UINT getButtons(Buttons buttons)
+   {
+      switch (buttons)
+      {
+      case Buttons::OK:
+      case Buttons::Quit: // There is no 'Quit' button on Windows :(
+         return MB_OK;
+      case Buttons::OKCancel:
+         return MB_OKCANCEL;
+      case Buttons::YesNo:
+         return MB_YESNO;
+      case Buttons::AbortRetryIgnore: // There is no 'Ignore Always' button on Windows
+         return MB_ABORTRETRYIGNORE;
+      default:
+         return MB_OK;
+      }
+   }
+
+   Selection getSelection(int response, Buttons buttons)
+   {
+      switch (response)
+      {
+      case IDOK:
+         return buttons == Buttons::Quit ? Selection::Quit : Selection::OK;
+      case IDCANCEL:
+         return Selection::Cancel;
+      case IDYES:
+         return Selection::Yes;
+      case IDNO:
+         return Selection::No;
+      case IDABORT:
+         return Selection::Abort;
+      case IDRETRY:
+         return Selection::Retry;
+      case IDIGNORE:
+         return Selection::Ignore;
+      default:
+         return Selection::None;
+      }
+   }
+
+   int getCommand(Selection selection)
+   {
+      switch (selection)
+      {
+      case Selection::OK:
+      case Selection::Quit:
+         return IDOK;
+      case Selection::Cancel:
+         return IDCANCEL;
+      case Selection::Yes:
+         return IDYES;
+      case Selection::No:
+         return IDNO;
+      case Selection::Abort:
+         return IDABORT;
+      case Selection::Retry:
+         return IDRETRY;
+      case Selection::Ignore:
+      case Selection::IgnoreAlways:
+         return IDIGNORE;
+      default:
+         return 0;
+      }
+   }
+
+   struct EscalationContext
+   {
+      Escalation escalation;
+      UINT_PTR raiseTimer;
+      UINT_PTR notifyTimer;
+      UINT_PTR resolveTimer;
+      bool dismissed;
+   };
+
+   /*!
+    * Thread timers carry no user data, so the escalation of the message box open on this thread is kept here
+    */
+   thread_local EscalationContext* activeEscalation = nullptr;
+
+   BOOL CALLBACK findMessageBox(HWND window, LPARAM data)
+   {
+      char className[8];
+      if (GetClassNameA(window, className, sizeof(className)) > 0 && lstrcmpA(className, "#32770") == 0)
+      {
+         *reinterpret_cast<HWND*>(data) = window;
+         return FALSE;
+      }
+      return TRUE;
+   }
+
+   HWND getMessageBoxWindow(DWORD threadId)
+   {
+      HWND window = nullptr;
+      EnumThreadWindows(threadId, findMessageBox, reinterpret_cast<LPARAM>(&window));
+      return window;
+   }
+
+   /*!
+    * Answers a message box with the given selection, as if the user had clicked the corresponding button. Posted, so
+    * that it is safe to call from any thread. Message boxes without a Cancel button ignore WM_CLOSE, so a message box
+    * without the matching button (e.g. one with Yes and No, answered with 'None') is dismissed through the button
+    * that declines it instead, and false is returned.
+    */
+   bool respond(HWND window, Selection selection)
+   {
+      int command = getCommand(selection);
+      if (command && GetDlgItem(window, command))
+      {
+         PostMessage(window, WM_COMMAND, MAKEWPARAM(command, BN_CLICKED), 0);
+         return true;
+      }
+
+      for (int fallback : { IDCANCEL, IDNO, IDIGNORE, IDOK })
+      {
+         if (GetDlgItem(window, fallback))
+         {
+            PostMessage(window, WM_COMMAND, MAKEWPARAM(fallback, BN_CLICKED), 0);
+            return false;
+         }
+      }
+
+      PostMessage(window, WM_CLOSE, 0, 0);
+      return false;
+   }
+
+   /*!
+    * Answers the message boxes open on all threads with 'shutdownSelection'
+    */
+   void closeOpenDialogs()
+   {
+      std::int64_t now = nowNanoseconds();
+      DialogInfo info;
+      for (const DialogSlot& slot : dialogSlots)
+      {
+         if (readDialogSlot(slot, info, now) && info.state == DialogState::Open)
+         {
+            HWND window = getMessageBoxWindow(static_cast<DWORD>(info.threadId));
+            if (window)
+            {
+               respond(window, static_cast<Selection>(shutdownSelection.load(std::memory_order_relaxed)));
+            }
+         }
+      }
+   }
+
+   /*!
+    * Answers the message box open on the given thread, if any, with 'OK'
+    */
+   void answerThreadDialog(unsigned long threadId)
+   {
+      HWND window = getMessageBoxWindow(static_cast<DWORD>(threadId));
+      if (window)
+      {
+         respond(window, Selection::OK);
+      }
+   }
+
+   VOID CALLBACK onEscalationTimer(HWND, UINT, UINT_PTR timer, DWORD)
+   {
+      KillTimer(nullptr, timer);
+
+      EscalationContext* context = activeEscalation;
+      if (!context)
+      {
+         return;
+      }
+
+      HWND window = getMessageBoxWindow(GetCurrentThreadId());
+      if (timer == context->raiseTimer)
+      {
+         context->raiseTimer = 0;
+         escalationsRaised.fetch_add(1, std::memory_order_relaxed);
+         if (window)
+         {
+            SetWindowPos(window, HWND_TOPMOST, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE);
+            SetForegroundWindow(window);
+            FLASHWINFO flash = { sizeof(FLASHWINFO), window, FLASHW_ALL | FLASHW_TIMERNOFG, 0, 0 };
+            FlashWindowEx(&flash);
+         }
+      }
+      else if (timer == context->notifyTimer)
+      {
+         context->notifyTimer = 0;
+         context->escalation.notify();
+      }
+      else if (timer == context->resolveTimer)
+      {
+         context->resolveTimer = 0;
+         escalationsResolved.fetch_add(1, std::memory_order_relaxed);
+         if (window && !respond(window, context->escalation.policy.resolution))
+         {
+            context->dismissed = true;
+         }
+      }
+   }
+
+   UINT_PTR setTimer(std::chrono::milliseconds delay)
+   {
+      return delay.count() > 0 ? SetTimer(nullptr, 0, static_cast<UINT>(delay.count()), onEscalationTimer) : 0;
+   }
+
+   void killTimer(UINT_PTR timer)
+   {
+      if (timer)
+      {
+         KillTimer(nullptr, timer);
+      }
+   }
+
+   /*!
+    * Runs a message box until it is dismissed. The message box's modal loop dispatches the thread timers used to
+    * escalate it.
+    */
+   int runMessageBox(LPCTSTR text,
+                     LPCTSTR caption,
+                     UINT flags,
+                     const char* message,
+                     std::size_t messageLength,
+                     const char* title,
+                     std::size_t titleLength,
+                     Style style)
+   {
+      EscalationContext escalation = { Escalation(message, messageLength, title, titleLength, style), 0, 0, 0, false };
+      escalation.raiseTimer = setTimer(escalation.escalation.policy.raiseAfter);
+      escalation.notifyTimer = setTimer(escalation.escalation.policy.notifyAfter);
+      escalation.resolveTimer = setTimer(escalation.escalation.policy.resolveAfter);
+
+      EscalationContext* previous = activeEscalation;
+      activeEscalation = &escalation;
+      int response = MessageBox(nullptr, text, caption, flags);
+      activeEscalation = previous;
+
+      killTimer(escalation.raiseTimer);
+      killTimer(escalation.notifyTimer);
+      killTimer(escalation.resolveTimer);
+
+      // The button that dismissed the message box does not stand for the resolution, which has none on this box
+      return escalation.dismissed ? 0 : response;
+   }
+#endif // defined(BOXER_BACKEND_QT/BOXER_BACKEND_GTK/BOXER_BACKEND_WIN32)
+} // namespace
+
+/*!
+ * The default style to apply to a message box
+ */
+constexpr Style kDefaultStyle = Style::Info;
+
+/*!
+ * The default buttons to provide on a message box
+ */
+constexpr Buttons kDefaultButtons = Buttons::OK;
+
+namespace
+{
+   /*!
+    * Implementation of show(). Neither the message nor the title needs to be null-terminated, which allows slices of
+    * larger buffers to be passed through to the toolkits that accept a length.
+    */
+   Selection showMessage(const char* message,
+                         std::size_t messageLength,
+                         const char* title,
+                         std::size_t titleLength,
+                         Style style,
+                         Buttons buttons)
+   {
+      BOXER_COUNT_ALLOCATIONS();
+      TrackedDialog tracked(title, titleLength, style);
+      if (!tracked.isAdmitted())
+      {
+         return static_cast<Selection>(shutdownSelection.load(std::memory_order_relaxed));
+      }
+
+#if defined(__linux__)
+      // Initializing a toolkit while memory is short can be what pushes the process (or the host) over the edge
+      if (static_cast<MemoryPressure>(memoryPressure.load(std::memory_order_relaxed)) == MemoryPressure::High)
+      {
+         return showWithoutToolkit(message, messageLength, title, titleLength, style, buttons);
+      }
+#endif // defined(__linux__)
+
+#if defined(BOXER_BACKEND_QT)
+      if (!getApplication())
+      {
+         return Selection::Error;
+      }
+
+      QMessageBox box(getIcon(style),
+                      QString::fromUtf8(title, static_cast<int>(titleLength)),
+                      QString::fromUtf8(message, static_cast<int>(messageLength)),
+                      QMessageBox::NoButton);
+      setButtons(box, buttons);
+
+      return getSelection(box, runDialog(box, message, messageLength, title, titleLength, style));
+#elif defined(BOXER_BACKEND_GTK)
+      if (!initGtk())
+      {
+         return Selection::Error;
+      }
+
+      // Create a parent window to stop gtk_dialog_run from complaining
+      GtkWidget* parent = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+
+      GtkWidget* dialog = gtk_message_dialog_new(GTK_WINDOW(parent),
+                                                 GTK_DIALOG_MODAL,
+                                                 getMessageType(style),
+                                                 getButtonsType(buttons),
+                                                 "%.*s",
+                                                 static_cast<int>(messageLength),
+                                                 message);
+      if (getButtonsType(buttons) == GTK_BUTTONS_NONE)
+      {
+         addButtons(GTK_DIALOG(dialog), buttons);
+      }
+      // GTK has no length parameter for the title, so it needs a terminated copy
+      ScratchTitle terminatedTitle(title, titleLength);
+      gtk_window_set_title(GTK_WINDOW(dialog), terminatedTitle.c_str());
+
+      centerWindows(parent, dialog);
+
+      Selection selection =
+         getSelection(runDialog(GTK_DIALOG(dialog), message, messageLength, title, titleLength, style));
+
+      gtk_widget_destroy(GTK_WIDGET(dialog));
+      gtk_widget_destroy(GTK_WIDGET(parent));
+      while (g_main_context_iteration(nullptr, false));
+
+      return selection;
+#elif defined(BOXER_BACKEND_WIN32)
+      UINT flags = MB_TASKMODAL;
+
+      flags |= getIcon(style);
+      flags |= getButtons(buttons);
+
+ #if defined(UNICODE)
+      std::wstring wideMessage;
+      std::wstring wideTitle;
+      if (!utf8ToUtf16(message, messageLength, wideMessage) || !utf8ToUtf16(title, titleLength, wideTitle))
+      {
+         return Selection::Error;
+      }
+
+      const WCHAR* messageArg = wideMessage.c_str();
+      const WCHAR* titleArg = wideTitle.c_str();
+ #else // defined(UNICODE)
+      // MessageBoxA has no length parameters, so it needs terminated copies of both strings
+      ScratchMessage terminatedMessage(message, messageLength);
+      ScratchTitle terminatedTitle(title, titleLength);
+      const char* messageArg = terminatedMessage.c_str();
+      const char* titleArg = terminatedTitle.c_str();
+ #endif // defined(UNICODE)
+
+      int response = runMessageBox(messageArg, titleArg, flags, message, messageLength, title, titleLength, style);
+
+      // shutdown() may have had to dismiss the message box through a button other than its selection
+      if (shuttingDown.load(std::memory_order_relaxed))
+      {
+         return static_cast<Selection>(shutdownSelection.load(std::memory_order_relaxed));
+      }
+      return getSelection(response, buttons);
+#endif // defined(BOXER_BACKEND_QT/BOXER_BACKEND_GTK/BOXER_BACKEND_WIN32)
+   }
+} // namespace
+
+/*!
+ * Blocking call to create a modal message box with the given message, title, style, and buttons. With Qt, message
+ * boxes can only be shown from the GUI thread, and 'Error' is returned on any other thread.
+ */
+BOXERAPI Selection show(const char* message, const char* title, Style style, Buttons buttons)
+{
+   return showMessage(message, std::strlen(message), title, std::strlen(title), style, buttons);
+}
+
+/*!
+ * Fills the given array with snapshots of up to 'capacity' open and pending message boxes, and returns how many were
+ * written. This never blocks or allocates, so it can be called from any thread while a message box is open.
+ */
+BOXERAPI std::size_t listDialogs(DialogInfo* dialogs, std::size_t capacity)
+{
+   std::int64_t now = nowNanoseconds();
+   std::size_t count = 0;
+   for (const DialogSlot& slot : dialogSlots)
+   {
+      if (count == capacity)
+      {
+         break;
+      }
+      if (readDialogSlot(slot, dialogs[count], now))
+      {
+         ++count;
+      }
+   }
+   return count;
+}
+
+/*!
+ * Convenience function to call listDialogs() for all tracked message boxes
+ */
+inline std::vector<DialogInfo> listDialogs()
+{
+   std::vector<DialogInfo> dialogs(kMaxTrackedDialogs);
+   dialogs.resize(listDialogs(dialogs.data(), dialogs.size()));
+   return dialogs;
+}
+
+/*!
+ * Installs a handler for the given signal that writes one line per open or pending message box to the given file
+ * descriptor, e.g. 'dumpDialogsOnSignal(SIGUSR1, STDERR_FILENO)'. Returns false if the handler could not be installed
+ * or signals are not supported on the current platform.
+ */
+BOXERAPI bool dumpDialogsOnSignal(int signalNumber, int fileDescriptor)
+{
+#if defined(__linux__)
+   dumpFileDescriptor = fileDescriptor;
+
+   struct sigaction action = {};
+   action.sa_handler = dumpDialogs;
+   action.sa_flags = SA_RESTART;
+   sigemptyset(&action.sa_mask);
+   return sigaction(signalNumber, &action, nullptr) == 0;
+#else // defined(__linux__)
+   (void)signalNumber;
+   (void)fileDescriptor;
+   return false;
+#endif // defined(__linux__)
+}
+
+/*!
+ * Sets how much work to spend on round-trips to the display server. Must be called before the first message box is
+ * shown to also affect the toolkit's initialization.
+ */
+BOXERAPI void setRoundTripMode(RoundTripMode mode)
+{
+#if defined(BOXER_BACKEND_GTK)
+   roundTripMode.store(static_cast<int>(mode), std::memory_order_relaxed);
+#else // defined(BOXER_BACKEND_GTK)
+   (void)mode;
+#endif // defined(BOXER_BACKEND_GTK)
+}
+
+/*!
+ * Starts watching memory pressure through a PSI trigger, replacing any earlier watcher. While the pressure is high,
+ * show() and Flow::step() do not touch the toolkit, and instead ask on the terminal if stdin and stderr are one, or
+ * otherwise only log the message box to stderr and return 'None'. Returns false if PSI is not available (it requires
+ * Linux 5.2 or later) or the trigger could not be set up.
+ */
+BOXERAPI bool watchMemoryPressure(const MemoryPressureOptions& options)
+{
+#if defined(__linux__)
+   int triggerDescriptor = open(options.path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+   if (triggerDescriptor < 0)
+   {
+      return false;
+   }
+
+   char trigger[64];
+   int length = snprintf(trigger,
+                         sizeof(trigger),
+                         "some %lld %lld",
+                         static_cast<long long>(options.stall.count()),
+                         static_cast<long long>(options.window.count()));
+   int stopDescriptors[2];
+   if (write(triggerDescriptor, trigger, static_cast<std::size_t>(length) + 1) < 0)
+   {
+      close(triggerDescriptor);
+      return false;
+   }
+   if (pipe2(stopDescriptors, O_CLOEXEC) != 0)
+   {
+      close(triggerDescriptor);
+      return false;
+   }
+
+   std::lock_guard<std::mutex> lock(memoryPressureMutex);
+   if (memoryPressureStopDescriptor >= 0)
+   {
+      close(memoryPressureStopDescriptor);
+   }
+   memoryPressureStopDescriptor = stopDescriptors[1];
+   unsigned int generation = ++memoryPressureGeneration;
+   memoryPressure.store(static_cast<int>(MemoryPressure::Normal), std::memory_order_relaxed);
+
+   std::thread(watchMemoryPressureTrigger,
+               triggerDescriptor,
+               stopDescriptors[0],
+               static_cast<int>(options.holdTime.count()),
+               generation).detach();
+   return true;
+#else // defined(__linux__)
+   (void)options;
+   return false;
+#endif // defined(__linux__)
+}
+
+/*!
+ * Convenience function to call watchMemoryPressure() with the default settings
+ */
+inline bool watchMemoryPressure()
+{
+   return watchMemoryPressure(MemoryPressureOptions());
+}
+
+/*!
+ * Stops watching memory pressure. Message boxes are shown by the toolkit again.
+ */
+BOXERAPI void stopWatchingMemoryPressure()
+{
+#if defined(__linux__)
+   std::lock_guard<std::mutex> lock(memoryPressureMutex);
+   if (memoryPressureStopDescriptor >= 0)
+   {
+      close(memoryPressureStopDescriptor);
+      memoryPressureStopDescriptor = -1;
+   }
+   ++memoryPressureGeneration;
+   memoryPressure.store(static_cast<int>(MemoryPressure::Unknown), std::memory_order_relaxed);
+#endif // defined(__linux__)
+}
+
+/*!
+ * Returns the current memory pressure, along with how often it has been high and message boxes have been shown without
+ * the toolkit since the program started
+ */
+BOXERAPI MemoryPressureStatus getMemoryPressureStatus()
+{
+   MemoryPressureStatus status;
+   status.pressure = static_cast<MemoryPressure>(memoryPressure.load(std::memory_order_relaxed));
+   status.triggers = memoryPressureTriggers.load(std::memory_order_relaxed);
+   status.fallbacks = memoryPressureFallbacks.load(std::memory_order_relaxed);
+   return status;
+}
+
+/*!
+ * Sets the rules for escalating unanswered message boxes of the given style. Applies to message boxes shown after the
+ * call.
+ */
+BOXERAPI void setEscalationPolicy(Style style, const EscalationPolicy& policy)
+{
+   std::lock_guard<std::mutex> lock(escalationMutex);
+   escalationPolicies[static_cast<std::size_t>(style)] = policy;
+}
+
+/*!
+ * Stops escalating unanswered message boxes of the given style
+ */
+BOXERAPI void clearEscalationPolicy(Style style)
+{
+   setEscalationPolicy(style, EscalationPolicy());
+}
+
+/*!
+ * Returns how many times each escalation stage has been applied since the program started
+ */
+BOXERAPI EscalationCounters getEscalationCounters()
+{
+   EscalationCounters counters;
+   counters.raised = escalationsRaised.load(std::memory_order_relaxed);
+   counters.notified = escalationsNotified.load(std::memory_order_relaxed);
+   counters.resolved = escalationsResolved.load(std::memory_order_relaxed);
+   return counters;
+}
+
+/*!
+ * Stops showing message boxes within the given deadline, e.g. before the process exits. New and pending message boxes
+ * are answered with 'selection' right away, and open ones are answered with it through their toolkit's event loop. On
+ * Windows, an open message box without a button for 'selection' is dismissed through the button that declines it,
+ * and show() still returns 'selection'. Once they are closed, the memory pressure watcher is stopped and the work
+ * Boxer queued on GTK's main context is released (GTK itself can not be deinitialized). Message boxes are not shown
+ * again after this call. Blocks for at most 'deadline'. May be called from a callback run by a message box's event
+ * loop (e.g. a quit or signal handler), in which case the caller's own message boxes are answered right away, and
+ * close once it returns to their event loops.
+ */
+BOXERAPI ShutdownReport shutdown(std::chrono::milliseconds deadline, Selection selection = Selection::None)
+{
+   typedef std::chrono::steady_clock Clock;
+   const Clock::time_point start = Clock::now();
+   const Clock::time_point end = start + deadline;
+   const std::chrono::milliseconds pollInterval(1);
+   const std::chrono::milliseconds closeInterval(100);
+
+   ShutdownReport report = {};
+   report.pendingDialogs = countDialogs(DialogState::Pending);
+   report.openDialogs = countDialogs(DialogState::Open);
+
+   shutdownSelection.store(static_cast<int>(selection), std::memory_order_relaxed);
+   {
+      std::lock_guard<std::mutex> lock(queueMutex);
+      shuttingDown.store(true, std::memory_order_relaxed);
+   }
+   queueCondition.notify_all();
+
+   // Pairs with the fence in TrackedDialog, so that a message box that missed the flag is seen in its slot below
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+
+   // Overlays have no event loop to close their message boxes through, so their queues are resolved right away
+   {
+      std::lock_guard<std::mutex> lock(overlaysMutex);
+      for (auto& resolver : overlayResolvers)
+      {
+         resolver.second();
+      }
+   }
+
+   while (countDialogs(DialogState::Pending) > 0 && Clock::now() < end)
+   {
+      std::this_thread::sleep_for(pollInterval);
+   }
+   Clock::time_point pendingEnd = Clock::now();
+   report.pendingDuration = std::chrono::duration_cast<std::chrono::microseconds>(pendingEnd - start);
+
+   // Closing is requested again periodically, in case a message box was still being set up when it was first asked.
+   // The caller's own message boxes are answered as well, but they can only close once it returns to their event
+   // loops, so they are not waited for.
+   const unsigned long callingThread = getThreadId();
+   if (countDialogs(DialogState::Open) > 0)
+   {
+      closeOpenDialogs();
+   }
+   Clock::time_point nextClose = Clock::now() + closeInterval;
+   while (countDialogs(DialogState::Open, callingThread) > 0 && Clock::now() < end)
+   {
+      if (Clock::now() >= nextClose)
+      {
+         closeOpenDialogs();
+         nextClose = Clock::now() + closeInterval;
+      }
+
+#if defined(BOXER_BACKEND_GTK)
+      // Other threads' dialogs can not run their main loops while the caller owns the main context, so it runs it
+      if (g_main_context_is_owner(nullptr))
+      {
+         g_main_context_iteration(nullptr, false);
+      }
+#endif // defined(BOXER_BACKEND_GTK)
+      std::this_thread::sleep_for(pollInterval);
+   }
+   Clock::time_point closeEnd = Clock::now();
+   report.closeDuration = std::chrono::duration_cast<std::chrono::microseconds>(closeEnd - pendingEnd);
+   report.completed = countDialogs(DialogState::Open, callingThread) == 0 && countDialogs(DialogState::Pending) == 0;
+
+   stopWatchingMemoryPressure();
+#if defined(BOXER_BACKEND_GTK)
+   while (g_idle_remove_by_data(&openDialogs));
+
+   // Finishes the destruction of closed dialogs, unless another thread still owns the main context or the caller is
+   // still inside the main loop of one of its own
+   if (report.completed && countDialogs(DialogState::Open) == 0)
+   {
+      while (g_main_context_iteration(nullptr, false));
+   }
+#endif // defined(BOXER_BACKEND_GTK)
+   report.teardownDuration = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - closeEnd);
+
+   return report;
+}
+
+#if defined(BOXER_ENABLE_ALLOCATION_STATS)
+/*!
+ * Returns the heap allocations made on the calling thread by its last call to show() or Flow::step()
+ */
+BOXERAPI AllocationStats getLastAllocationStats()
+{
+   return lastAllocationStats;
+}
+#endif // defined(BOXER_ENABLE_ALLOCATION_STATS)
+
+#if defined(BOXER_ENABLE_TEST_HOOKS)
+/*!
+ * Test-only hook: once each subsequent message box is mapped, respond to it with the given selection after the given
+ * delay. The response is emitted through the toolkit itself, so the whole path of show() is exercised. Currently only
+ * supported with GTK and Qt.
+ */
+BOXERAPI void injectSelection(Selection selection, unsigned int delayMilliseconds)
+{
+#if defined(BOXER_BACKEND_GTK) || defined(BOXER_BACKEND_QT)
+   injectedSelection.enabled = true;
+   injectedSelection.selection = selection;
+   injectedSelection.delayMilliseconds = delayMilliseconds;
+#else // defined(BOXER_BACKEND_GTK) || defined(BOXER_BACKEND_QT)
+   (void)selection;
+   (void)delayMilliseconds;
+#endif // defined(BOXER_BACKEND_GTK) || defined(BOXER_BACKEND_QT)
+}
+
+/*!
+ * Test-only hook: stop responding to message boxes automatically
+ */
+BOXERAPI void clearInjectedSelection()
+{
+#if defined(BOXER_BACKEND_GTK) || defined(BOXER_BACKEND_QT)
+   injectedSelection.enabled = false;
+#endif // defined(BOXER_BACKEND_GTK) || defined(BOXER_BACKEND_QT)
+}
+#endif // defined(BOXER_ENABLE_TEST_HOOKS)
+
+/*!
+ * Convenience function to call show() with the default buttons
+ */
+inline Selection show(const char* message, const char* title, Style style)
+{
+   return show(message, title, style, kDefaultButtons);
+}
+
+/*!
+ * Convenience function to call show() with the default style
+ */
+inline Selection show(const char* message, const char* title, Buttons buttons)
+{
+   return show(message, title, kDefaultStyle, buttons);
+}
+
+/*!
+ * Convenience function to call show() with the default style and buttons
+ */
+inline Selection show(const char* message, const char* title)
+{
+   return show(message, title, kDefaultStyle, kDefaultButtons);
+}
+
+#if defined(BOXER_HAS_STRING_VIEW)
+/*!
+ * Blocking call to create a modal message box with the given message, title, style, and buttons. Both strings are
+ * passed through by length where the toolkit allows it, so slices of larger buffers are not copied. Only GTK's title
+ * and MessageBoxA's arguments are copied into a reusable per-thread buffer, as those APIs require null-terminated
+ * strings.
+ */
+BOXERAPI Selection show(std::string_view message, std::string_view title, Style style, Buttons buttons)
+{
+   return showMessage(message.data(), message.size(), title.data(), title.size(), style, buttons);
+}
+
+/*!
+ * Convenience function to call show() with the default buttons
+ */
+inline Selection show(std::string_view message, std::string_view title, Style style)
+{
+   return show(message, title, style, kDefaultButtons);
+}
+
+/*!
+ * Convenience function to call show() with the default style
+ */
+inline Selection show(std::string_view message, std::string_view title, Buttons buttons)
+{
+   return show(message, title, kDefaultStyle, buttons);
+}
+
+/*!
+ * Convenience function to call show() with the default style and buttons
+ */
+inline Selection show(std::string_view message, std::string_view title)
+{
+   return show(message, title, kDefaultStyle, kDefaultButtons);
+}
+#endif // defined(BOXER_HAS_STRING_VIEW)
+
+namespace
+{
+   /*!
+    * Whether a debugger is attached to the process, i.e. whether a breakpoint would be caught rather than kill it
+    */
+   bool isDebuggerAttached()
+   {
+#if defined(__linux__)
+      FILE* status = std::fopen("/proc/self/status", "r");
+      if (!status)
+      {
+         return false;
+      }
+
+      char line[128];
+      long tracer = 0;
+      while (std::fgets(line, sizeof(line), status))
+      {
+         if (std::strncmp(line, "TracerPid:", 10) == 0)
+         {
+            tracer = std::strtol(line + 10, nullptr, 10);
+            break;
+         }
+      }
+      std::fclose(status);
+      return tracer != 0;
+#elif defined(WINDOWS)
+      return IsDebuggerPresent() != FALSE;
+#else // defined(__linux__/WINDOWS)
+      return false;
+#endif // defined(__linux__/WINDOWS)
+   }
+} // namespace
+
+/*!
+ * Called by BOXER_ASSERT when an assertion fails. Asks the user whether to abort the program, break into the debugger
+ * ('Retry'), or ignore the failure once or for the rest of the program's run, in which case 'ignored' is set. Without
+ * a debugger attached, 'Retry' is treated like 'Ignore', as the breakpoint would otherwise kill the process. Inline,
+ * so that its code and strings are only emitted into programs that use BOXER_ASSERT.
+ */
+inline void handleAssertion(const char* condition,
+                            const char* message,
+                            const char* file,
+                            int line,
+                            std::atomic<bool>& ignored)
+{
+   std::string details = std::string(message) + "\n\nCondition: " + condition + "\nLocation: " + file + ":"
+      + std::to_string(line);
+
+   switch (show(details.c_str(), "Assertion Failed", Style::Error, Buttons::AbortRetryIgnore))
+   {
+   case Selection::Retry:
+      if (isDebuggerAttached())
+      {
+#if defined(WINDOWS)
+         DebugBreak();
+#else // defined(WINDOWS)
+         std::raise(SIGTRAP);
+#endif // defined(WINDOWS)
+      }
+      break;
+   case Selection::IgnoreAlways:
+      ignored.store(true, std::memory_order_relaxed);
+      break;
+   case Selection::Ignore:
+   case Selection::None:
+      break;
+   case Selection::Error:
+      // Nobody can be asked, so behave like a failed assert()
+      std::fprintf(stderr, "Assertion failed: %s (%s), %s:%d\n", condition, message, file, line);
+      std::abort();
+   case Selection::Abort:
+   default:
+      std::abort();
+   }
+}
+
+/*!
+ * A multi-step sequence of message boxes that share a single window. Each step swaps the contents of the window in
+ * place instead of destroying and recreating it, which avoids flicker and the cost of building a new dialog per step.
+ * Like show(), steps with Qt can only be run on the GUI thread.
+ */
+class BOXERAPI Flow
+{
+public:
+   Flow() = default;
+   ~Flow();
+
+   Flow(const Flow&) = delete;
+   Flow& operator=(const Flow&) = delete;
+
+   /*!
+    * Blocking call to update the flow's message box with the given message, title, style, and buttons, and wait for
+    * the user's selection. The window stays open between steps until the flow is destroyed or close() is called.
+    */
+   Selection step(const char* message, const char* title, Style style, Buttons buttons);
+
+   /*!
+    * Convenience function to call step() with the default buttons
+    */
+   Selection step(const char* message, const char* title, Style style)
+   {
+      return step(message, title, style, kDefaultButtons);
+   }
+
+   /*!
+    * Convenience function to call step() with the default style
+    */
+   Selection step(const char* message, const char* title, Buttons buttons)
+   {
+      return step(message, title, kDefaultStyle, buttons);
+   }
+
+   /*!
+    * Convenience function to call step() with the default style and buttons
+    */
+   Selection step(const char* message, const char* title)
+   {
+      return step(message, title, kDefaultStyle, kDefaultButtons);
+   }
+
+   /*!
+    * Closes the flow's window. A subsequent call to step() opens a new one.
+    */
+   void close();
+
+private:
+#if defined(BOXER_BACKEND_QT)
+   QMessageBox* box = nullptr;
+#elif defined(BOXER_BACKEND_GTK)
+   GtkWidget* parent = nullptr;
+   GtkWidget* dialog = nullptr;
+   Buttons currentButtons = kDefaultButtons;
+#endif // defined(BOXER_BACKEND_QT/BOXER_BACKEND_GTK)
+};
+
+Flow::~Flow()
+{
+   close();
+}
+
+Selection Flow::step(const char* message, const char* title, Style style, Buttons buttons)
+{
+#if defined(BOXER_BACKEND_QT) || defined(BOXER_BACKEND_GTK)
+   // Not on Windows, where each step is tracked by show()
+   BOXER_COUNT_ALLOCATIONS();
+   TrackedDialog tracked(title, std::strlen(title), style);
+   if (!tracked.isAdmitted())
+   {
+      return static_cast<Selection>(shutdownSelection.load(std::memory_order_relaxed));
+   }
+
+#if defined(__linux__)
+   // The same fallback as show(), as a first step would initialize the toolkit and later steps still allocate
+   if (static_cast<MemoryPressure>(memoryPressure.load(std::memory_order_relaxed)) == MemoryPressure::High)
+   {
+      return showWithoutToolkit(message, std::strlen(message), title, std::strlen(title), style, buttons);
+   }
+#endif // defined(__linux__)
+#endif // defined(BOXER_BACKEND_QT) || defined(BOXER_BACKEND_GTK)
+
+#if defined(BOXER_BACKEND_QT)
+   // Checked for every step, as the box may only be used from the GUI thread
+   if (!getApplication())
+   {
+      return Selection::Error;
+   }
+
+   if (!box)
+   {
+      box = new PersistentMessageBox();
+   }
+
+   // The member only names the public base, but the flow never creates any other kind of message box
+   PersistentMessageBox& flowBox = *static_cast<PersistentMessageBox*>(box);
+
+   // Only the contents change between steps, the window itself stays mapped
+   flowBox.setIcon(getIcon(style));
+   flowBox.setWindowTitle(QString::fromUtf8(title));
+   flowBox.setText(QString::fromUtf8(message));
+   setButtons(flowBox, buttons);
+
+   return getSelection(flowBox, runDialog(flowBox, message, std::strlen(message), title, std::strlen(title), style));
+#elif defined(BOXER_BACKEND_GTK)
+   if (!dialog)
+   {
+      if (!initGtk())
+      {
+         return Selection::Error;
+      }
+
+      // Create a parent window to stop gtk_dialog_run from complaining
+      parent = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+
+      dialog = gtk_message_dialog_new(GTK_WINDOW(parent),
+                                      GTK_DIALOG_MODAL,
+                                      getMessageType(style),
+                                      GTK_BUTTONS_NONE,
+                                      "%s",
+                                      message);
+      addButtons(GTK_DIALOG(dialog), buttons);
+
+      centerWindows(parent, dialog);
+   }
+   else
+   {
+      // Only the contents change between steps, the window itself stays mapped
+      g_object_set(dialog, "message-type", getMessageType(style), "text", message, nullptr);
+
+      if (buttons != currentButtons)
+      {
+         removeButtons(GTK_DIALOG(dialog));
+         addButtons(GTK_DIALOG(dialog), buttons);
+      }
+   }
+
+   currentButtons = buttons;
+   gtk_window_set_title(GTK_WINDOW(dialog), title);
+
+   return getSelection(runDialog(GTK_DIALOG(dialog), message, std::strlen(message), title, std::strlen(title), style));
+#elif defined(BOXER_BACKEND_WIN32)
+   // MessageBox does not allow its contents to be changed once shown, so each step is a separate message box
+   return show(message, title, style, buttons);
+#endif // defined(BOXER_BACKEND_QT/BOXER_BACKEND_GTK/BOXER_BACKEND_WIN32)
+}
+
+void Flow::close()
+{
+#if defined(BOXER_BACKEND_QT)
+   delete box;
+   box = nullptr;
+#elif defined(BOXER_BACKEND_GTK)
+   if (!dialog)
+   {
+      return;
+   }
+
+   gtk_widget_destroy(GTK_WIDGET(dialog));
+   gtk_widget_destroy(GTK_WIDGET(parent));
+   while (g_main_context_iteration(nullptr, false));
+
+   dialog = nullptr;
+   parent = nullptr;
+#endif // defined(BOXER_BACKEND_QT/BOXER_BACKEND_GTK)
+}
+
+/*!
+ * The contents of a message box queued on an Overlay
+ */
+struct OverlayDialog
+{
+   std::string message;
+   std::string title;
+   Style style;
+   Buttons buttons;
+};
+
+/*!
+ * Handle to the user's selection for a message box queued on an Overlay. Handles may be copied and checked from any
+ * thread.
+ */
+class OverlayHandle
+{
+public:
+   /*!
+    * Whether the user has made a selection yet
+    */
+   bool ready() const
+   {
+      return result && result->load(std::memory_order_acquire) >= 0;
+   }
+
+   /*!
+    * The user's selection, or 'None' if the message box is still open or waiting to be shown
+    */
+   Selection selection() const
+   {
+      return ready() ? static_cast<Selection>(result->load(std::memory_order_acquire)) : Selection::None;
+   }
+
+private:
+   friend class Overlay;
+
+   std::shared_ptr<std::atomic<int>> result;
+};
+
+/*!
+ * A queue of message boxes that are drawn by the application itself, as an overlay inside its own render loop, rather
+ * than in a separate window. Message boxes may be queued from any thread without blocking. Once per frame, the render
+ * thread calls frame() with a function that draws the front message box with the application's immediate-mode UI and
+ * returns the selection made this frame, if any. Once shutdown() has been called, queued message boxes are resolved
+ * with its selection, and push() returns handles that are already resolved with it.
+ */
+class BOXERAPI Overlay
+{
+public:
+   /*!
+    * Draws a message box for the current frame. Returns the user's selection, or 'None' if the user has not made one
+    * during this frame.
+    */
+   using DrawFunction = std::function<Selection(const OverlayDialog&)>;
+
+   Overlay();
+   ~Overlay();
+
+   Overlay(const Overlay&) = delete;
+   Overlay& operator=(const Overlay&) = delete;
+
+   /*!
+    * Queues a message box with the given message, title, style, and buttons, and returns a handle to the user's
+    * selection
+    */
+   OverlayHandle push(const char* message, const char* title, Style style, Buttons buttons);
+
+   /*!
+    * Convenience function to call push() with the default buttons
+    */
+   OverlayHandle push(const char* message, const char* title, Style style)
+   {
+      return push(message, title, style, kDefaultButtons);
+   }
+
+   /*!
+    * Convenience function to call push() with the default style
+    */
+   OverlayHandle push(const char* message, const char* title, Buttons buttons)
+   {
+      return push(message, title, kDefaultStyle, buttons);
+   }
+
+   /*!
+    * Convenience function to call push() with the default style and buttons
+    */
+   OverlayHandle push(const char* message, const char* title)
+   {
+      return push(message, title, kDefaultStyle, kDefaultButtons);
+   }
+
+   /*!
+    * Per-frame hook, to be called from the render thread. Draws the front message box, if any, through the given
+    * function, and resolves its handle once a selection has been made. Returns whether a message box was drawn.
+    */
+   bool frame(const DrawFunction& draw);
+
+   /*!
+    * The number of message boxes that are open or waiting to be shown
+    */
+   std::size_t pending() const;
+
+   /*!
+    * Resolves all queued message boxes with 'None' and removes them. Must be called from the render thread.
+    */
+   void clear();
+
+private:
+   struct Entry
+   {
+      OverlayDialog dialog;
+      std::shared_ptr<std::atomic<int>> result;
+   };
+
+   /*!
+    * Resolves all queued message boxes with 'shutdownSelection'. They are only removed by the render thread.
+    */
+   void resolveForShutdown();
+
+   mutable std::mutex mutex;
+   std::deque<Entry> queue;
+};
+
+Overlay::Overlay()
+{
+   std::lock_guard<std::mutex> lock(overlaysMutex);
+   overlayResolvers[this] = [this]()
+   {
+      resolveForShutdown();
+   };
+}
+
+Overlay::~Overlay()
+{
+   {
+      std::lock_guard<std::mutex> lock(overlaysMutex);
+      overlayResolvers.erase(this);
+   }
+   clear();
+}
+
+OverlayHandle Overlay::push(const char* message, const char* title, Style style, Buttons buttons)
+{
+   Entry entry;
+   entry.dialog.message = message;
+   entry.dialog.title = title;
+   entry.dialog.style = style;
+   entry.dialog.buttons = buttons;
+   entry.result = std::make_shared<std::atomic<int>>(-1);
+
+   OverlayHandle handle;
+   handle.result = entry.result;
+
+   // Checked under the lock, so that an entry is either resolved by resolveForShutdown() or not queued at all
+   std::lock_guard<std::mutex> lock(mutex);
+   if (shuttingDown.load(std::memory_order_relaxed))
+   {
+      entry.result->store(shutdownSelection.load(std::memory_order_relaxed), std::memory_order_release);
+      return handle;
+   }
+   queue.push_back(std::move(entry));
+   return handle;
+}
+
+bool Overlay::frame(const DrawFunction& draw)
+{
+   const Entry* front = nullptr;
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      // The entries were resolved by shutdown(), so they are only removed
+      if (shuttingDown.load(std::memory_order_relaxed))
+      {
+         queue.clear();
+      }
+
+      if (queue.empty())
+      {
+         return false;
+      }
+
+      // Only the render thread removes entries, and pushing to a deque does not move existing ones, so the front
+      // entry stays valid without holding the lock while it is drawn
+      front = &queue.front();
+   }
+
+   Selection selection = draw(front->dialog);
+   if (selection != Selection::None)
+   {
+      front->result->store(static_cast<int>(selection), std::memory_order_release);
+
+      std::lock_guard<std::mutex> lock(mutex);
+      queue.pop_front();
+   }
+
+   return true;
+}
+
+std::size_t Overlay::pending() const
+{
+   std::lock_guard<std::mutex> lock(mutex);
+   return shuttingDown.load(std::memory_order_relaxed) ? 0 : queue.size();
+}
+
+void Overlay::clear()
+{
+   std::lock_guard<std::mutex> lock(mutex);
+   for (Entry& entry : queue)
+   {
+      entry.result->store(static_cast<int>(Selection::None), std::memory_order_release);
+   }
+   queue.clear();
+}
+
+void Overlay::resolveForShutdown()
+{
+   std::lock_guard<std::mutex> lock(mutex);
+   for (Entry& entry : queue)
+   {
+      entry.result->store(shutdownSelection.load(std::memory_order_relaxed), std::memory_order_release);
+   }
+}
+
+/*!
+ * A message box to render with renderSnapshots(), and the PNG file to write it to
+ */
+struct SnapshotJob
+{
+   const char* message;
+   const char* title;
+   Style style;
+   Buttons buttons;
+   const char* path;
+};
+
+/*!
+ * Renders the contents of a message box with the given message, title, style, and buttons offscreen, without showing
+ * it, and writes them to a PNG file at the given path. Returns whether the snapshot was written. Currently only
+ * supported with GTK and Qt.
+ */
+BOXERAPI bool renderSnapshot(const char* message, const char* title, Style style, Buttons buttons, const char* path)
+{
+#if defined(BOXER_BACKEND_QT)
+   if (!getApplication())
+   {
+      return false;
+   }
+
+   QMessageBox box(getIcon(style), QString::fromUtf8(title), QString::fromUtf8(message), QMessageBox::NoButton);
+   setButtons(box, buttons);
+   box.ensurePolished();
+   box.adjustSize();
+
+   return box.grab().save(QString::fromUtf8(path));
+#elif defined(BOXER_BACKEND_GTK)
+   if (!initGtk())
+   {
+      return false;
+   }
+
+   GtkWidget* dialog = gtk_message_dialog_new(nullptr,
+                                              static_cast<GtkDialogFlags>(0),
+                                              getMessageType(style),
+                                              GTK_BUTTONS_NONE,
+                                              "%s",
+                                              message);
+   addButtons(GTK_DIALOG(dialog), buttons);
+   gtk_window_set_title(GTK_WINDOW(dialog), title);
+
+   // Move the dialog's contents into an offscreen window, which renders them into a surface instead of mapping them
+   GtkWidget* contents = gtk_bin_get_child(GTK_BIN(dialog));
+   g_object_ref(contents);
+   gtk_container_remove(GTK_CONTAINER(dialog), contents);
+
+   GtkWidget* offscreen = gtk_offscreen_window_new();
+   gtk_container_add(GTK_CONTAINER(offscreen), contents);
+   g_object_unref(contents);
+
+   gtk_widget_show_all(offscreen);
+   while (g_main_context_iteration(nullptr, false));
+
+   cairo_surface_t* surface = gtk_offscreen_window_get_surface(GTK_OFFSCREEN_WINDOW(offscreen));
+   bool written = surface && cairo_surface_write_to_png(surface, path) == CAIRO_STATUS_SUCCESS;
+
+   gtk_widget_destroy(offscreen);
+   gtk_widget_destroy(dialog);
+   while (g_main_context_iteration(nullptr, false));
+
+   return written;
+#else // defined(BOXER_BACKEND_QT/BOXER_BACKEND_GTK)
+   (void)message;
+   (void)title;
+   (void)style;
+   (void)buttons;
+   (void)path;
+   return false;
+#endif // defined(BOXER_BACKEND_QT/BOXER_BACKEND_GTK)
+}
+
+/*!
+ * Renders the given snapshots, fanned out across the given number of worker processes, and returns how many of them
+ * could not be written. On Linux each worker is a forked process with its own toolkit state, so the toolkit must not
+ * have been initialized by the calling process yet. Elsewhere, the snapshots are rendered one after another.
+ */
+BOXERAPI std::size_t renderSnapshots(const SnapshotJob* jobs, std::size_t count, unsigned int workers)
+{
+#if defined(__linux__)
+   if (workers > 1 && count > 1)
+   {
+      std::vector<pid_t> children;
+      std::vector<unsigned int> unforked;
+      for (unsigned int worker = 0; worker < workers && worker < count; ++worker)
+      {
+         pid_t child = fork();
+         if (child == 0)
+         {
+            std::size_t failures = 0;
+            for (std::size_t i = worker; i < count; i += workers)
+            {
+               if (!renderSnapshot(jobs[i].message, jobs[i].title, jobs[i].style, jobs[i].buttons, jobs[i].path))
+               {
+                  ++failures;
+               }
+            }
+            _exit(failures > 255 ? 255 : static_cast<int>(failures));
+         }
+
+         if (child > 0)
+         {
+            children.push_back(child);
+         }
+         else
+         {
+            unforked.push_back(worker);
+         }
+      }
+
+      // Any jobs of workers that could not be forked are rendered in this process
+      std::size_t failures = 0;
+      for (unsigned int worker : unforked)
+      {
+         for (std::size_t i = worker; i < count; i += workers)
+         {
+            if (!renderSnapshot(jobs[i].message, jobs[i].title, jobs[i].style, jobs[i].buttons, jobs[i].path))
+            {
+               ++failures;
+            }
+         }
+      }
+
+      for (pid_t child : children)
+      {
+         int status = 0;
+         if (waitpid(child, &status, 0) != child || !WIFEXITED(status))
+         {
+            ++failures;
+            continue;
+         }
+         failures += static_cast<std::size_t>(WEXITSTATUS(status));
+      }
+
+      return failures;
+   }
+#else // defined(__linux__)
+   (void)workers;
+#endif // defined(__linux__)
+
+   std::size_t failures = 0;
+   for (std::size_t i = 0; i < count; ++i)
+   {
+      if (!renderSnapshot(jobs[i].message, jobs[i].title, jobs[i].style, jobs[i].buttons, jobs[i].path))
+      {
+         ++failures;
+      }
+   }
+   return failures;
+}
+
+/*!
+ * Compares a snapshot against a stored golden image. Returns true if both have the same size and no channel of any
+ * pixel differs by more than 'tolerance'. Currently only supported with GTK and Qt.
+ */
+BOXERAPI bool compareSnapshot(const char* path, const char* goldenPath, unsigned int tolerance)
+{
+#if defined(BOXER_BACKEND_QT)
+   QImage image = QImage(QString::fromUtf8(path)).convertToFormat(QImage::Format_ARGB32);
+   QImage golden = QImage(QString::fromUtf8(goldenPath)).convertToFormat(QImage::Format_ARGB32);
+   if (image.isNull() || golden.isNull() || image.width() != golden.width() || image.height() != golden.height())
+   {
+      return false;
+   }
+
+   for (int y = 0; y < image.height(); ++y)
+   {
+      if (!pixelsMatch(image.constScanLine(y), golden.constScanLine(y), static_cast<std::size_t>(image.width()), tolerance))
+      {
+         return false;
+      }
+   }
+   return true;
+#elif defined(BOXER_BACKEND_GTK)
+   cairo_surface_t* image = cairo_image_surface_create_from_png(path);
+   cairo_surface_t* golden = cairo_image_surface_create_from_png(goldenPath);
+
+   bool matches = cairo_surface_status(image) == CAIRO_STATUS_SUCCESS
+      && cairo_surface_status(golden) == CAIRO_STATUS_SUCCESS
+      && cairo_image_surface_get_width(image) == cairo_image_surface_get_width(golden)
+      && cairo_image_surface_get_height(image) == cairo_image_surface_get_height(golden);
+
+   if (matches)
+   {
+      cairo_surface_flush(image);
+      cairo_surface_flush(golden);
+
+      const unsigned char* imageData = cairo_image_surface_get_data(image);
+      const unsigned char* goldenData = cairo_image_surface_get_data(golden);
+      int imageStride = cairo_image_surface_get_stride(image);
+      int goldenStride = cairo_image_surface_get_stride(golden);
+      std::size_t width = static_cast<std::size_t>(cairo_image_surface_get_width(image));
+
+      for (int y = 0; matches && y < cairo_image_surface_get_height(image); ++y)
+      {
+         matches = pixelsMatch(imageData + y * imageStride, goldenData + y * goldenStride, width, tolerance);
+      }
+   }
+
+   cairo_surface_destroy(image);
+   cairo_surface_destroy(golden);
+   return matches;
+#else // defined(BOXER_BACKEND_QT/BOXER_BACKEND_GTK)
+   (void)path;
+   (void)goldenPath;
+   (void)tolerance;
+   return false;
+#endif // defined(BOXER_BACKEND_QT/BOXER_BACKEND_GTK)
+}
 
- #if defined(UNICODE)
-   std::wstring wideMessage;
-   std::wstring wideTitle;
-   if (!utf8ToUtf16(message, wideMessage) || !utf8ToUtf16(title, wideTitle))
+/*!
+ * Severities of log records passed to a LogSink
+ */
+enum class Severity
+{
+   Trace,
+   Debug,
+   Info,
+   Warning,
+   Error,
+   Critical
+};
+
+/*!
+ * Returns the style of message box used for log records of the given severity
+ */
+inline Style getStyle(Severity severity)
+{
+   switch (severity)
    {
-      return Selection::Error;
+   case Severity::Warning:
+      return Style::Warning;
+   case Severity::Error:
+   case Severity::Critical:
+      return Style::Error;
+   default:
+      return Style::Info;
    }
+}
 
-   const WCHAR* messageArg = wideMessage.c_str();
-   const WCHAR* titleArg = wideTitle.c_str();
- #else // defined(UNICODE)
-   const char* messageArg = message;
-   const char* titleArg = title;
- #endif // defined(UNICODE)
+namespace
+{
+   bool isDigit(char character)
+   {
+      return character >= '0' && character <= '9';
+   }
 
-   return getSelection(MessageBox(nullptr, messageArg, titleArg, flags), buttons);
-#endif // defined(__linux__/WINDOWS)
-}
+   bool isHexDigit(char character)
+   {
+      return isDigit(character) || (character >= 'a' && character <= 'f') || (character >= 'A' && character <= 'F');
+   }
+
+   bool isWordCharacter(char character)
+   {
+      return isDigit(character) || (character >= 'a' && character <= 'z') || (character >= 'A' && character <= 'Z')
+         || character == '_';
+   }
+
+   /*!
+    * Returns the length of the IPv4 address (with an optional port) at the start of the text, or 0 if there is none
+    */
+   std::size_t matchIpv4(const char* text)
+   {
+      const char* position = text;
+      for (int part = 0; part < 4; ++part)
+      {
+         if (part > 0)
+         {
+            if (*position != '.')
+            {
+               return 0;
+            }
+            ++position;
+         }
+
+         const char* digits = position;
+         while (isDigit(*position) && position - digits < 3)
+         {
+            ++position;
+         }
+         if (position == digits || isDigit(*position))
+         {
+            return 0;
+         }
+      }
+
+      if (*position == ':' && isDigit(position[1]))
+      {
+         ++position;
+         while (isDigit(*position))
+         {
+            ++position;
+         }
+      }
+
+      return isWordCharacter(*position) ? 0 : static_cast<std::size_t>(position - text);
+   }
+
+   /*!
+    * Returns the length of the IPv6 address at the start of the text, or 0 if there is none. This takes eight groups
+    * of up to four hex digits, or fewer around a single '::', possibly ending in an IPv4 address. The address has to
+    * contain a decimal digit, so that scopes such as 'a::b' in identifiers are not taken for addresses, and colons
+    * that only separate numbers (as in '12:30:45') are never enough.
+    */
+   std::size_t matchIpv6(const char* text)
+   {
+      const char* position = text;
+      int groups = 0;
+      bool compressed = false;
+      bool hasDigit = false;
+      if (position[0] == ':' && position[1] == ':')
+      {
+         compressed = true;
+         position += 2;
+      }
+
+      for (;;)
+      {
+         std::size_t ipv4Length = (groups > 0 || compressed) && groups < 7 ? matchIpv4(position) : 0;
+         if (ipv4Length > 0)
+         {
+            position += ipv4Length;
+            groups += 2;
+            hasDigit = true;
+            break;
+         }
+
+         const char* digits = position;
+         while (isHexDigit(*position) && position - digits < 4)
+         {
+            hasDigit = hasDigit || isDigit(*position);
+            ++position;
+         }
+         if (position == digits || isWordCharacter(*position))
+         {
+            return 0;
+         }
+         ++groups;
+
+         if (*position != ':')
+         {
+            break;
+         }
+
+         if (position[1] == ':')
+         {
+            if (compressed)
+            {
+               return 0;
+            }
+            compressed = true;
+            position += 2;
+            if (!isHexDigit(*position))
+            {
+               break;
+            }
+         }
+         else if (isHexDigit(position[1]))
+         {
+            ++position;
+         }
+         else
+         {
+            // A colon that ends the sentence rather than separating groups
+            break;
+         }
+      }
+
+      bool complete = compressed ? groups < 8 : groups == 8;
+      return complete && hasDigit ? static_cast<std::size_t>(position - text) : 0;
+   }
+
+   /*!
+    * Returns the length of the UUID (in the 8-4-4-4-12 form) at the start of the text, or 0 if there is none
+    */
+   std::size_t matchUuid(const char* text)
+   {
+      const std::size_t groupLengths[] = { 8, 4, 4, 4, 12 };
+      const char* position = text;
+      for (std::size_t group = 0; group < 5; ++group)
+      {
+         if (group > 0)
+         {
+            if (*position != '-')
+            {
+               return 0;
+            }
+            ++position;
+         }
+
+         for (std::size_t i = 0; i < groupLengths[group]; ++i, ++position)
+         {
+            if (!isHexDigit(*position))
+            {
+               return 0;
+            }
+         }
+      }
+
+      return isWordCharacter(*position) ? 0 : static_cast<std::size_t>(position - text);
+   }
+
+   /*!
+    * Returns the length of the unit (one to three letters, as in '30s', '12ms' or '512MiB') at the start of the text,
+    * or 0 if there is none
+    */
+   std::size_t matchUnit(const char* text)
+   {
+      std::size_t length = 0;
+      while (length < 3 && isWordCharacter(text[length]) && !isDigit(text[length]) && text[length] != '_')
+      {
+         ++length;
+      }
+      return isWordCharacter(text[length]) ? 0 : length;
+   }
+} // namespace
 
 /*!
- * Convenience function to call show() with the default buttons
+ * Returns the template of a message, with the parts that usually differ between otherwise identical messages masked:
+ * IPv4 addresses (and their ports) and IPv6 addresses become '<ip>', hexadecimal IDs (prefixed with '0x', UUIDs, or
+ * at least eight hex digits including a decimal one) become '<hex>', numbers (along with a unit such as in '30s' or
+ * '12ms') become '<num>' and quoted strings become '<str>'. E.g. 'Connection to 10.0.3.17:5432 failed (attempt 412)'
+ * becomes 'Connection to <ip> failed (attempt <num>)', as does 'Connection to fe80::1 failed (attempt 7)'. Runs in a
+ * single pass.
  */
-inline Selection show(const char* message, const char* title, Style style)
+BOXERAPI std::string normalizeMessage(const char* message)
 {
-   return show(message, title, style, kDefaultButtons);
+   std::string normalized;
+   normalized.reserve(std::strlen(message));
+
+   const char* position = message;
+   while (*position != '\0')
+   {
+      char character = *position;
+      bool wordStart = position == message || !isWordCharacter(position[-1]);
+
+      // Only quotes at the start of a word open a quoted string, so that apostrophes (as in "can't") are kept
+      if ((character == '"' || character == '\'') && wordStart)
+      {
+         const char* closing = std::strchr(position + 1, character);
+         if (closing)
+         {
+            normalized += "<str>";
+            position = closing + 1;
+            continue;
+         }
+      }
+
+      // The groups of a UUID are words of their own, so it is matched as a whole before its first group is taken alone
+      if (wordStart && isHexDigit(character))
+      {
+         std::size_t uuidLength = matchUuid(position);
+         if (uuidLength > 0)
+         {
+            normalized += "<hex>";
+            position += uuidLength;
+            continue;
+         }
+      }
+
+      // IPv6 addresses may start with '::', and their groups may be words of their own
+      if (wordStart && (character == ':' || isHexDigit(character)) && (position == message || position[-1] != ':'))
+      {
+         std::size_t ipLength = matchIpv6(position);
+         if (ipLength > 0)
+         {
+            normalized += "<ip>";
+            position += ipLength;
+            continue;
+         }
+      }
+
+      if (!isWordCharacter(character))
+      {
+         normalized += character;
+         ++position;
+         continue;
+      }
+
+      const char* wordEnd = position;
+      bool digitsOnly = true;
+      bool hexOnly = true;
+      bool hasDigit = false;
+      while (isWordCharacter(*wordEnd))
+      {
+         digitsOnly = digitsOnly && isDigit(*wordEnd);
+         hexOnly = hexOnly && isHexDigit(*wordEnd);
+         hasDigit = hasDigit || isDigit(*wordEnd);
+         ++wordEnd;
+      }
+      std::size_t wordLength = static_cast<std::size_t>(wordEnd - position);
+
+      const char* digitsEnd = position;
+      while (isDigit(*digitsEnd))
+      {
+         ++digitsEnd;
+      }
+      bool hasUnit = digitsEnd != position && digitsEnd != wordEnd
+         && matchUnit(digitsEnd) == static_cast<std::size_t>(wordEnd - digitsEnd);
+
+      // Checked first, so that a hex ID is not taken for a number with a unit (as in '0xab' or '1234abcd')
+      if (wordLength > 2 && position[0] == '0' && (position[1] == 'x' || position[1] == 'X')
+         && std::all_of(position + 2, wordEnd, isHexDigit))
+      {
+         normalized += "<hex>";
+      }
+      else if (!digitsOnly && hexOnly && hasDigit && wordLength >= 8)
+      {
+         normalized += "<hex>";
+      }
+      else if (digitsOnly || hasUnit)
+      {
+         std::size_t ipLength = matchIpv4(position);
+         if (ipLength > 0)
+         {
+            normalized += "<ip>";
+            position += ipLength;
+            continue;
+         }
+
+         // Decimal fractions are part of the number, as is the unit after them (as in '1.5s')
+         if (digitsOnly && *wordEnd == '.' && isDigit(wordEnd[1]))
+         {
+            ++wordEnd;
+            while (isDigit(*wordEnd))
+            {
+               ++wordEnd;
+            }
+            wordEnd += matchUnit(wordEnd);
+         }
+         normalized += "<num>";
+      }
+      else
+      {
+         normalized.append(position, wordLength);
+      }
+      position = wordEnd;
+   }
+
+   return normalized;
 }
 
 /*!
- * Convenience function to call show() with the default style
+ * Adapter for logging frameworks that turns log records at or above a severity threshold into message boxes. Records
+ * are shown asynchronously by a worker thread, so logging a record only costs the logging thread an enqueue and never
+ * blocks it on a modal message box. Records are coalesced by their template (see normalizeMessage()), so records that
+ * only differ in numbers, addresses, IDs or quoted strings are treated as repeats. Repeats of a record that is still
+ * queued are folded into it, with up to 'kMaxVariants' of the differing messages listed in its message box, and a
+ * template is not shown again until 'throttle' has passed since it was last shown. Records arriving while the queue is
+ * full are dropped. Destroying the sink drops the queued records and answers the message box it has open, if any.
  */
-inline Selection show(const char* message, const char* title, Buttons buttons)
+class BOXERAPI LogSink
 {
-   return show(message, title, kDefaultStyle, buttons);
+public:
+   LogSink(std::string title,
+           Severity threshold = Severity::Error,
+           std::chrono::milliseconds throttle = std::chrono::seconds(60),
+           std::size_t capacity = 64);
+   ~LogSink();
+
+   LogSink(const LogSink&) = delete;
+   LogSink& operator=(const LogSink&) = delete;
+
+   /*!
+    * The maximum number of differing messages listed in the message box of a coalesced record
+    */
+   static constexpr std::size_t kMaxVariants = 5;
+
+   /*!
+    * Queues a log record to be shown if its severity is at or above the threshold. Never blocks on a message box.
+    */
+   void log(Severity severity, const char* message);
+
+   /*!
+    * The number of records that were dropped because the queue was full
+    */
+   std::uint64_t dropped() const
+   {
+      return droppedRecords.load(std::memory_order_relaxed);
+   }
+
+   /*!
+    * The number of records that were not shown, because they repeated the template of a queued record or were
+    * throttled
+    */
+   std::uint64_t suppressed() const
+   {
+      return suppressedRecords.load(std::memory_order_relaxed);
+   }
+
+private:
+   struct Record
+   {
+      Severity severity;
+      std::string message;
+      std::string messageTemplate;
+      std::vector<std::string> variants;
+      std::size_t repeats;
+   };
+
+   void run();
+   void present(const std::string& message, Style style);
+
+   const std::string title;
+   const Severity threshold;
+   const std::chrono::milliseconds throttle;
+   const std::size_t capacity;
+
+   std::mutex mutex;
+   std::condition_variable condition;
+   std::deque<Record> queue;
+   bool stopping = false;
+   bool finished = false;
+   unsigned long workerThread = 0; // Guarded by 'mutex', 0 until the worker has started
+   std::atomic<std::uint64_t> droppedRecords{ 0 };
+   std::atomic<std::uint64_t> suppressedRecords{ 0 };
+
+   // Only used by the worker thread, keyed by template
+   std::unordered_map<std::string, std::chrono::steady_clock::time_point> lastShown;
+
+#if defined(BOXER_BACKEND_QT)
+   /*!
+    * A record handed to the GUI thread. Shared with the callback posted there, which may outlive the sink.
+    */
+   struct Delivery
+   {
+      std::mutex mutex;
+      std::condition_variable condition;
+      bool finished = false;
+   };
+
+   // The record currently handed to the GUI thread, if any. Guarded by 'mutex'.
+   std::shared_ptr<Delivery> delivery;
+#endif // defined(BOXER_BACKEND_QT)
+
+   std::thread worker;
+};
+
+LogSink::LogSink(std::string title, Severity threshold, std::chrono::milliseconds throttle, std::size_t capacity)
+   : title(std::move(title)), threshold(threshold), throttle(throttle), capacity(capacity)
+{
+   worker = std::thread(&LogSink::run, this);
+}
+
+LogSink::~LogSink()
+{
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+      queue.clear();
+
+#if defined(BOXER_BACKEND_QT)
+      // Stops waiting for the GUI thread, which might never get to the record (e.g. if its event loop has ended)
+      if (delivery)
+      {
+         std::lock_guard<std::mutex> deliveryLock(delivery->mutex);
+         delivery->finished = true;
+         delivery->condition.notify_one();
+      }
+#endif // defined(BOXER_BACKEND_QT)
+   }
+   condition.notify_all();
+
+#if defined(BOXER_BACKEND_GTK) || defined(BOXER_BACKEND_WIN32)
+   // A message box the worker has open would keep it from returning until the user dismisses it, so it is answered.
+   // With GTK, a message box that is still waiting for its turn is answered once it is shown.
+   {
+      std::unique_lock<std::mutex> lock(mutex);
+      if (workerThread != 0)
+      {
+#if defined(BOXER_BACKEND_GTK)
+         guint answerSource = g_timeout_add(50, answerThreadDialogs,
+                                            reinterpret_cast<gpointer>(static_cast<std::uintptr_t>(workerThread)));
+#endif // defined(BOXER_BACKEND_GTK)
+         while (!finished)
+         {
+#if defined(BOXER_BACKEND_WIN32)
+            answerThreadDialog(workerThread);
+#endif // defined(BOXER_BACKEND_WIN32)
+            condition.wait_for(lock, std::chrono::milliseconds(50));
+         }
+#if defined(BOXER_BACKEND_GTK)
+         g_source_remove(answerSource);
+#endif // defined(BOXER_BACKEND_GTK)
+      }
+   }
+#endif // defined(BOXER_BACKEND_GTK) || defined(BOXER_BACKEND_WIN32)
+
+   worker.join();
+}
+
+void LogSink::log(Severity severity, const char* message)
+{
+   if (severity < threshold)
+   {
+      return;
+   }
+
+   // Normalized before taking the lock, so that other logging threads do not wait on it
+   std::string messageTemplate = normalizeMessage(message);
+
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (Record& record : queue)
+      {
+         if (record.severity == severity && record.messageTemplate == messageTemplate)
+         {
+            ++record.repeats;
+            if (record.variants.size() < kMaxVariants && record.message != message
+               && std::find(record.variants.begin(), record.variants.end(), message) == record.variants.end())
+            {
+               record.variants.emplace_back(message);
+            }
+            suppressedRecords.fetch_add(1, std::memory_order_relaxed);
+            return;
+         }
+      }
+
+      if (queue.size() >= capacity)
+      {
+         droppedRecords.fetch_add(1, std::memory_order_relaxed);
+         return;
+      }
+
+      Record record;
+      record.severity = severity;
+      record.message = message;
+      record.messageTemplate = std::move(messageTemplate);
+      record.repeats = 0;
+      queue.push_back(std::move(record));
+   }
+   condition.notify_one();
+}
+
+void LogSink::run()
+{
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      workerThread = getThreadId();
+   }
+
+   for (;;)
+   {
+      Record record;
+      {
+         std::unique_lock<std::mutex> lock(mutex);
+         condition.wait(lock, [this] { return stopping || !queue.empty(); });
+         if (stopping)
+         {
+            // Lets the destructor stop answering message boxes on this thread
+            finished = true;
+            condition.notify_all();
+            return;
+         }
+
+         record = std::move(queue.front());
+         queue.pop_front();
+      }
+
+      std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+      auto shown = lastShown.find(record.messageTemplate);
+      if (shown != lastShown.end() && now - shown->second < throttle)
+      {
+         // The repeats folded into the record were already counted when they were logged
+         suppressedRecords.fetch_add(1, std::memory_order_relaxed);
+         continue;
+      }
+
+      // Forget records that are no longer throttled, so that the map does not grow without bounds
+      if (lastShown.size() >= capacity * 4)
+      {
+         for (auto entry = lastShown.begin(); entry != lastShown.end();)
+         {
+            entry = now - entry->second >= throttle ? lastShown.erase(entry) : std::next(entry);
+         }
+      }
+      lastShown[record.messageTemplate] = now;
+
+      if (record.repeats > 0)
+      {
+         record.message += "\n\n(repeated " + std::to_string(record.repeats) + " more times)";
+      }
+      if (!record.variants.empty())
+      {
+         record.message += "\n\nVariants:";
+         for (const std::string& variant : record.variants)
+         {
+            record.message += "\n" + variant;
+         }
+      }
+      present(record.message, getStyle(record.severity));
+   }
 }
 
 /*!
- * Convenience function to call show() with the default style and buttons
+ * Shows a record and waits for it to be dismissed. Qt widgets may only be used on the GUI thread, so with Qt the record
+ * is shown there by the application's event loop, while the worker waits for it.
  */
-inline Selection show(const char* message, const char* title)
+void LogSink::present(const std::string& message, Style style)
 {
-   return show(message, title, kDefaultStyle, kDefaultButtons);
+#if defined(BOXER_BACKEND_QT)
+   QCoreApplication* application = QCoreApplication::instance();
+   if (!application)
+   {
+      droppedRecords.fetch_add(1, std::memory_order_relaxed);
+      return;
+   }
+
+   std::shared_ptr<Delivery> current = std::make_shared<Delivery>();
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (stopping)
+      {
+         return;
+      }
+      delivery = current;
+   }
+
+   // Everything is captured by value, as the sink may be destroyed before the GUI thread gets to the record
+   std::string sinkTitle = title;
+   QTimer::singleShot(0, application, [current, message, sinkTitle, style]()
+   {
+      show(message.c_str(), sinkTitle.c_str(), style, Buttons::OK);
+
+      std::lock_guard<std::mutex> lock(current->mutex);
+      current->finished = true;
+      current->condition.notify_one();
+   });
+
+   {
+      std::unique_lock<std::mutex> lock(current->mutex);
+      current->condition.wait(lock, [&current] { return current->finished; });
+   }
+
+   std::lock_guard<std::mutex> lock(mutex);
+   delivery.reset();
+#else // defined(BOXER_BACKEND_QT)
+   show(message.c_str(), title.c_str(), style, Buttons::OK);
+#endif // defined(BOXER_BACKEND_QT)
 }
 
 } // namespace boxer
 
+/*!
+ * BOXER_ENABLE_ASSERT controls whether BOXER_ASSERT is compiled in. Like assert(), it defaults to enabled unless NDEBUG
+ * is defined.
+ */
+#if !defined(BOXER_ENABLE_ASSERT)
+ #if defined(NDEBUG)
+  #define BOXER_ENABLE_ASSERT 0
+ #else // defined(NDEBUG)
+  #define BOXER_ENABLE_ASSERT 1
+ #endif // defined(NDEBUG)
+#endif // !defined(BOXER_ENABLE_ASSERT)
+
+/*!
+ * Shows an Abort / Retry / Ignore / Ignore Always message box if 'condition' is false. Each assertion site has its own
+ * flag, so once 'Ignore Always' is chosen the site only costs a relaxed load. When compiled out, neither the condition
+ * nor the message end up in the binary.
+ */
+#if BOXER_ENABLE_ASSERT
+ #define BOXER_ASSERT(condition, message) \
+   do \
+   { \
+      static std::atomic<bool> boxerAssertIgnored(false); \
+      if (!boxerAssertIgnored.load(std::memory_order_relaxed) && !(condition)) \
+      { \
+         ::boxer::handleAssertion(#condition, message, __FILE__, __LINE__, boxerAssertIgnored); \
+      } \
+   } while (false)
+#else // BOXER_ENABLE_ASSERT
+ #define BOXER_ASSERT(condition, message) \
+   do \
+   { \
+      static_cast<void>(sizeof(!(condition))); \
+   } while (false)
+#endif // BOXER_ENABLE_ASSERT
+
+#if defined(BOXER_ENABLE_ALLOCATION_STATS)
+/*
+ * Replacements for the global allocation functions, used to count allocations while a message box is shown. These
+ * live at global scope, so they replace the allocators of the whole program when allocation stats are enabled.
+ */
+void* operator new(std::size_t size)
+{
+   boxer::countNew(size);
+   if (void* pointer = std::malloc(size ? size : 1))
+   {
+      return pointer;
+   }
+   throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+   return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+   std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+   std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+   std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+   std::free(pointer);
+}
+
+ #if defined(__GLIBC__)
+extern "C"
+{
+   void* __libc_malloc(std::size_t size);
+   void* __libc_calloc(std::size_t count, std::size_t size);
+   void* __libc_realloc(void* pointer, std::size_t size);
+
+   // glibc routes its own allocations through these symbols, so GLib / GTK allocations are counted as well
+   void* malloc(std::size_t size)
+   {
+      boxer::countMalloc(size);
+      return __libc_malloc(size);
+   }
+
+   void* calloc(std::size_t count, std::size_t size)
+   {
+      boxer::countMalloc(count * size);
+      return __libc_calloc(count, size);
+   }
+
+   void* realloc(void* pointer, std::size_t size)
+   {
+      boxer::countMalloc(size);
+      return __libc_realloc(pointer, size);
+   }
+}
+ #endif // defined(__GLIBC__)
+#endif // defined(BOXER_ENABLE_ALLOCATION_STATS)
+
 namespace std {
     namespace boxer_detail {
         const map<boxer::Style, const string> styleToString = {
@@ -318,7 +4076,8 @@ namespace std {
             { boxer::Buttons::OK, "OK" },
             { boxer::Buttons::OKCancel, "OKCancel" },
             { boxer::Buttons::YesNo, "YesNo" },
-            { boxer::Buttons::Quit, "Quit" }
+            { boxer::Buttons::Quit, "Quit" },
+            { boxer::Buttons::AbortRetryIgnore, "AbortRetryIgnore" }
         };
 
         const map<boxer::Selection, const string> selectionToString = {
@@ -328,7 +4087,25 @@ namespace std {
             { boxer::Selection::No, "No" },
             { boxer::Selection::Quit, "Quit" },
             { boxer::Selection::None, "None" },
-            { boxer::Selection::Error, "Error" }
+            { boxer::Selection::Error, "Error" },
+            { boxer::Selection::Abort, "Abort" },
+            { boxer::Selection::Retry, "Retry" },
+            { boxer::Selection::Ignore, "Ignore" },
+            { boxer::Selection::IgnoreAlways, "IgnoreAlways" }
+        };
+
+        const map<boxer::Severity, const string> severityToString = {
+            { boxer::Severity::Trace, "Trace" },
+            { boxer::Severity::Debug, "Debug" },
+            { boxer::Severity::Info, "Info" },
+            { boxer::Severity::Warning, "Warning" },
+            { boxer::Severity::Error, "Error" },
+            { boxer::Severity::Critical, "Critical" }
+        };
+
+        const map<boxer::DialogState, const string> dialogStateToString = {
+            { boxer::DialogState::Pending, "Pending" },
+            { boxer::DialogState::Open, "Open" }
         };
     } // namespace
 
@@ -343,8 +4120,21 @@ namespace std {
     const string& to_string(const boxer::Selection selection) {
         return boxer_detail::selectionToString.at(selection);
     }
+
+    const string& to_string(const boxer::Severity severity) {
+        return boxer_detail::severityToString.at(severity);
+    }
+
+    const string& to_string(const boxer::DialogState state) {
+        return boxer_detail::dialogStateToString.at(state);
+    }
 } // namespace std
 
+#undef BOXER_BACKEND_QT
+#undef BOXER_BACKEND_GTK
+#undef BOXER_BACKEND_WIN32
+#undef BOXER_HAS_STRING_VIEW
+
 #ifdef UNDEF_WINDOWS
 #undef UNDEF_WINDOWS
 #undef WINDOWS
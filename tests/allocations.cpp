@@ -0,0 +1,74 @@
+// Regression test for the heap allocations Boxer itself makes per message box. Fails when a call to show() makes more
+// allocations through operator new than the stored ceiling, so that any increase has to come with a deliberate
+// change of kMaxBoxerAllocations. The toolkit's allocations are printed, but not checked.
+//
+// Build and run on Linux, with a display (e.g. under Xvfb):
+//   g++ -std=c++11 -I. tests/allocations.cpp $(pkg-config --cflags --libs gtk+-3.0) -pthread -o allocations
+//   xvfb-run ./allocations
+
+#define BOXER_ENABLE_TEST_HOOKS
+#define BOXER_ENABLE_ALLOCATION_STATS
+#include <boxer.hpp>
+
+#include <cstdio>
+#include <string>
+
+namespace
+{
+   /*!
+    * The most allocations Boxer may make through operator new for a single message box, once the toolkit is
+    * initialized
+    */
+   constexpr std::size_t kMaxBoxerAllocations = 0;
+
+   const boxer::Style kStyles[] = { boxer::Style::Info, boxer::Style::Warning, boxer::Style::Error, boxer::Style::Question };
+
+   const boxer::Buttons kButtons[] = { boxer::Buttons::OK, boxer::Buttons::OKCancel, boxer::Buttons::YesNo,
+                                       boxer::Buttons::Quit, boxer::Buttons::AbortRetryIgnore };
+} // namespace
+
+int main()
+{
+   // Answers every message box as soon as it is mapped
+   boxer::injectSelection(boxer::Selection::None, 0);
+
+   // The first message box also initializes the toolkit, which is not what this test is about
+   if (boxer::show("Warming up", "Allocations") == boxer::Selection::Error)
+   {
+      std::fprintf(stderr, "allocations: could not show a message box, is there a display?\n");
+      return 1;
+   }
+
+   int failures = 0;
+   for (boxer::Style style : kStyles)
+   {
+      for (boxer::Buttons buttons : kButtons)
+      {
+         boxer::show("Counting allocations", "Allocations", style, buttons);
+         boxer::AllocationStats stats = boxer::getLastAllocationStats();
+
+         bool failed = stats.boxerAllocations > kMaxBoxerAllocations;
+         failures += failed ? 1 : 0;
+         std::printf("%s %s/%s: boxer %zu allocations (%zu bytes), toolkit %zu allocations (%zu bytes)\n",
+                     failed ? "FAIL" : "ok",
+                     std::to_string(style).c_str(),
+                     std::to_string(buttons).c_str(),
+                     stats.boxerAllocations,
+                     stats.boxerBytes,
+                     stats.toolkitAllocations,
+                     stats.toolkitBytes);
+      }
+   }
+
+   boxer::clearInjectedSelection();
+
+   if (failures > 0)
+   {
+      std::fprintf(stderr,
+                   "allocations: %d message boxes made more than %zu allocations in Boxer\n",
+                   failures,
+                   kMaxBoxerAllocations);
+      return 1;
+   }
+   return 0;
+}
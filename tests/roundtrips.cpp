@@ -0,0 +1,366 @@
+// Counts the X11 round-trips of showing a message box, with the standard and the minimal round-trip mode. Each mode is
+// run in a child process, which connects to the X server through a proxy in this process. The proxy counts the
+// replies the server sends, each of which answers a request the client may have had to wait for, and the bytes sent
+// in each direction. Latency can be added to every reply to see how the modes compare over a slow connection. Fails
+// unless the minimal mode needs clearly fewer replies than the standard one.
+//
+// Build and run on Linux, with a local display whose access control is disabled (the proxy listens on another
+// display number, for which there is no cookie):
+//   g++ -std=c++11 -I. tests/roundtrips.cpp $(pkg-config --cflags --libs gtk+-3.0) -pthread -o roundtrips
+//   xvfb-run -s "-ac" ./roundtrips [latency in milliseconds]
+
+#define BOXER_ENABLE_TEST_HOOKS
+#include <boxer.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+   /*!
+    * The display number the proxy listens on, added to the number of the real display
+    */
+   constexpr int kProxyDisplayOffset = 50;
+
+   /*!
+    * The most replies the minimal mode may need, as a percentage of the replies the standard mode needs
+    */
+   constexpr std::size_t kMaxMinimalRepliesPercent = 90;
+
+   /*!
+    * What passed through the proxy while a message box was shown
+    */
+   struct Counts
+   {
+      std::size_t replies = 0;
+      std::size_t requestBytes = 0;
+      std::size_t responseBytes = 0;
+   };
+
+   /*!
+    * A client connection and the matching connection to the X server, with the server's data that has not been
+    * parsed yet
+    */
+   struct Connection
+   {
+      int client = -1;
+      int server = -1;
+      bool started = false;
+      bool bigEndian = false;
+      bool setupDone = false;
+      std::string pending;
+   };
+
+   std::string getSocketPath(int display)
+   {
+      return "/tmp/.X11-unix/X" + std::to_string(display);
+   }
+
+   int connectTo(const std::string& path)
+   {
+      int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+      sockaddr_un address = {};
+      address.sun_family = AF_UNIX;
+      std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+      if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+      {
+         if (fd >= 0)
+         {
+            close(fd);
+         }
+         return -1;
+      }
+      return fd;
+   }
+
+   int listenOn(const std::string& path)
+   {
+      unlink(path.c_str());
+      int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+      sockaddr_un address = {};
+      address.sun_family = AF_UNIX;
+      std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+      if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, 4) != 0)
+      {
+         if (fd >= 0)
+         {
+            close(fd);
+         }
+         return -1;
+      }
+      return fd;
+   }
+
+   bool writeAll(int fd, const char* data, std::size_t size)
+   {
+      while (size > 0)
+      {
+         ssize_t written = write(fd, data, size);
+         if (written <= 0)
+         {
+            return false;
+         }
+         data += written;
+         size -= static_cast<std::size_t>(written);
+      }
+      return true;
+   }
+
+   std::uint32_t readCard(const std::string& data, std::size_t offset, std::size_t size, bool bigEndian)
+   {
+      std::uint32_t value = 0;
+      for (std::size_t i = 0; i < size; ++i)
+      {
+         std::size_t index = bigEndian ? offset + i : offset + size - 1 - i;
+         value = (value << 8) | static_cast<unsigned char>(data[index]);
+      }
+      return value;
+   }
+
+   /*!
+    * Consumes the complete messages the server sent on a connection, counting the replies among them
+    */
+   void parseResponses(Connection& connection, Counts& counts)
+   {
+      std::string& data = connection.pending;
+      std::size_t offset = 0;
+      for (;;)
+      {
+         std::size_t available = data.size() - offset;
+         std::size_t size = 0;
+         unsigned char code = 0;
+         if (!connection.setupDone)
+         {
+            if (available < 8)
+            {
+               break;
+            }
+            size = 8 + 4 * readCard(data, offset + 6, 2, connection.bigEndian);
+         }
+         else
+         {
+            if (available < 32)
+            {
+               break;
+            }
+            // Replies and generic events carry their additional length, errors and other events are 32 bytes
+            code = static_cast<unsigned char>(data[offset]) & 0x7f;
+            bool extended = code == 1 || code == 35;
+            size = 32 + (extended ? 4 * readCard(data, offset + 4, 4, connection.bigEndian) : 0);
+         }
+
+         if (available < size)
+         {
+            break;
+         }
+
+         counts.replies += connection.setupDone && code == 1 ? 1 : 0;
+         connection.setupDone = true;
+         offset += size;
+      }
+      data.erase(0, offset);
+   }
+
+   /*!
+    * Forwards the connections of the child until it exits
+    */
+   Counts runProxy(int listener, pid_t child, const std::string& serverPath, std::chrono::milliseconds latency)
+   {
+      Counts counts;
+      std::vector<Connection> connections;
+      char buffer[65536];
+
+      while (waitpid(child, nullptr, WNOHANG) == 0)
+      {
+         std::vector<pollfd> fds;
+         fds.push_back({ listener, POLLIN, 0 });
+         for (const Connection& connection : connections)
+         {
+            fds.push_back({ connection.client, POLLIN, 0 });
+            fds.push_back({ connection.server, POLLIN, 0 });
+         }
+
+         if (poll(fds.data(), fds.size(), 50) <= 0)
+         {
+            continue;
+         }
+
+         if (fds[0].revents & POLLIN)
+         {
+            Connection connection;
+            connection.client = accept(listener, nullptr, nullptr);
+            connection.server = connectTo(serverPath);
+            connections.push_back(connection);
+            continue;
+         }
+
+         for (std::size_t i = 0; i < connections.size(); ++i)
+         {
+            Connection& connection = connections[i];
+            if (connection.client < 0)
+            {
+               continue;
+            }
+
+            if (fds[1 + 2 * i].revents & (POLLIN | POLLHUP))
+            {
+               ssize_t size = read(connection.client, buffer, sizeof(buffer));
+               if (size > 0 && !connection.started)
+               {
+                  // The first byte of the connection setup gives the byte order of the whole connection
+                  connection.bigEndian = buffer[0] == 'B';
+                  connection.started = true;
+               }
+               if (size <= 0 || !writeAll(connection.server, buffer, static_cast<std::size_t>(size)))
+               {
+                  close(connection.client);
+                  close(connection.server);
+                  connection.client = -1;
+                  connection.server = -1;
+                  continue;
+               }
+               counts.requestBytes += static_cast<std::size_t>(size);
+            }
+
+            if (fds[2 + 2 * i].revents & (POLLIN | POLLHUP))
+            {
+               ssize_t size = read(connection.server, buffer, sizeof(buffer));
+               if (size <= 0)
+               {
+                  close(connection.client);
+                  close(connection.server);
+                  connection.client = -1;
+                  connection.server = -1;
+                  continue;
+               }
+
+               std::size_t replies = counts.replies;
+               connection.pending.append(buffer, static_cast<std::size_t>(size));
+               parseResponses(connection, counts);
+               if (counts.replies > replies)
+               {
+                  std::this_thread::sleep_for(latency * (counts.replies - replies));
+               }
+
+               if (!writeAll(connection.client, buffer, static_cast<std::size_t>(size)))
+               {
+                  close(connection.client);
+                  close(connection.server);
+                  connection.client = -1;
+                  connection.server = -1;
+                  continue;
+               }
+               counts.responseBytes += static_cast<std::size_t>(size);
+            }
+         }
+      }
+
+      for (const Connection& connection : connections)
+      {
+         if (connection.client >= 0)
+         {
+            close(connection.client);
+            close(connection.server);
+         }
+      }
+      return counts;
+   }
+
+   /*!
+    * Shows a message box in a child process connected to the proxy, and returns what passed through the proxy
+    */
+   bool measure(boxer::RoundTripMode mode, int listener, int proxyDisplay, const std::string& serverPath,
+                std::chrono::milliseconds latency, Counts& counts)
+   {
+      auto start = std::chrono::steady_clock::now();
+      pid_t child = fork();
+      if (child < 0)
+      {
+         return false;
+      }
+
+      if (child == 0)
+      {
+         close(listener);
+         setenv("DISPLAY", (":" + std::to_string(proxyDisplay)).c_str(), 1);
+         boxer::setRoundTripMode(mode);
+         boxer::injectSelection(boxer::Selection::None, 0);
+         bool shown = boxer::show("Counting round-trips", "Round-trips") != boxer::Selection::Error;
+         _exit(shown ? 0 : 1);
+      }
+
+      counts = runProxy(listener, child, serverPath, latency);
+
+      int status = 0;
+      waitpid(child, &status, 0);
+      std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+      std::printf("%-8s %4zu replies, %7zu bytes sent, %7zu bytes received, %7.1f ms\n",
+                  mode == boxer::RoundTripMode::Minimal ? "minimal" : "standard",
+                  counts.replies,
+                  counts.requestBytes,
+                  counts.responseBytes,
+                  elapsed.count());
+      return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+   }
+} // namespace
+
+int main(int argc, char* argv[])
+{
+   std::chrono::milliseconds latency(argc > 1 ? std::atoi(argv[1]) : 0);
+
+   const char* display = std::getenv("DISPLAY");
+   if (!display || display[0] != ':')
+   {
+      std::fprintf(stderr, "roundtrips: DISPLAY has to name a local display, such as :99\n");
+      return 1;
+   }
+
+   int serverDisplay = std::atoi(display + 1);
+   int proxyDisplay = serverDisplay + kProxyDisplayOffset;
+   std::string proxyPath = getSocketPath(proxyDisplay);
+   int listener = listenOn(proxyPath);
+   if (listener < 0)
+   {
+      std::fprintf(stderr, "roundtrips: could not listen on %s\n", proxyPath.c_str());
+      return 1;
+   }
+
+   Counts standard;
+   Counts minimal;
+   bool succeeded = measure(boxer::RoundTripMode::Standard, listener, proxyDisplay, getSocketPath(serverDisplay),
+                            latency, standard)
+                    && measure(boxer::RoundTripMode::Minimal, listener, proxyDisplay, getSocketPath(serverDisplay),
+                               latency, minimal);
+
+   close(listener);
+   unlink(proxyPath.c_str());
+
+   if (!succeeded)
+   {
+      std::fprintf(stderr, "roundtrips: could not show a message box through the proxy\n");
+      return 1;
+   }
+
+   if (standard.replies == 0 || minimal.replies * 100 > standard.replies * kMaxMinimalRepliesPercent)
+   {
+      std::fprintf(stderr,
+                   "roundtrips: the minimal mode needed %zu replies, more than %zu%% of the standard mode's %zu\n",
+                   minimal.replies,
+                   kMaxMinimalRepliesPercent,
+                   standard.replies);
+      return 1;
+   }
+   return 0;
+}
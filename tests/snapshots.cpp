@@ -0,0 +1,114 @@
+// Visual regression test for every combination of Style and Buttons. Renders the whole matrix offscreen through
+// renderSnapshots(), fanned out across worker processes, and compares each snapshot against its golden image in the
+// given directory. Run with '--update' to (re)record the golden images instead, e.g. after an intended change of the
+// message boxes' look. Golden images depend on the toolkit version, theme and fonts, so they should be recorded in
+// the same environment that runs the test.
+//
+// Build and run on Linux, with a display (e.g. under Xvfb):
+//   g++ -std=c++11 -I. tests/snapshots.cpp $(pkg-config --cflags --libs gtk+-3.0) -o snapshots
+//   xvfb-run ./snapshots --update tests/golden
+//   xvfb-run ./snapshots tests/golden
+
+#include <boxer.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+namespace
+{
+   const char* kOutputDirectory = "snapshots";
+   constexpr unsigned int kWorkers = 8;
+   constexpr unsigned int kTolerance = 2;
+
+   const boxer::Style kStyles[] = { boxer::Style::Info, boxer::Style::Warning, boxer::Style::Error, boxer::Style::Question };
+
+   const boxer::Buttons kButtons[] = { boxer::Buttons::OK, boxer::Buttons::OKCancel, boxer::Buttons::YesNo,
+                                       boxer::Buttons::Quit, boxer::Buttons::AbortRetryIgnore };
+
+   std::string getFileName(boxer::Style style, boxer::Buttons buttons)
+   {
+      return std::to_string(style) + "-" + std::to_string(buttons) + ".png";
+   }
+} // namespace
+
+int main(int argc, char* argv[])
+{
+   bool update = argc == 3 && std::strcmp(argv[1], "--update") == 0;
+   if (argc != 2 && !update)
+   {
+      std::fprintf(stderr, "Usage: snapshots [--update] GOLDEN_DIRECTORY\n");
+      return 2;
+   }
+   std::string goldenDirectory = argv[argc - 1];
+
+   // Recording renders straight into the golden directory
+   std::string outputDirectory = update ? goldenDirectory : kOutputDirectory;
+   mkdir(outputDirectory.c_str(), 0755);
+
+   std::vector<std::string> fileNames;
+   for (boxer::Style style : kStyles)
+   {
+      for (boxer::Buttons buttons : kButtons)
+      {
+         fileNames.push_back(getFileName(style, buttons));
+      }
+   }
+
+   // The paths are only taken once all of them exist, as the jobs point into them
+   std::vector<std::string> paths;
+   for (const std::string& fileName : fileNames)
+   {
+      paths.push_back(outputDirectory + "/" + fileName);
+   }
+
+   std::vector<boxer::SnapshotJob> jobs;
+   std::size_t index = 0;
+   for (boxer::Style style : kStyles)
+   {
+      for (boxer::Buttons buttons : kButtons)
+      {
+         jobs.push_back({ "The quick brown fox jumps over the lazy dog.", "Snapshot", style, buttons,
+                          paths[index++].c_str() });
+      }
+   }
+
+   std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+   std::size_t renderFailures = boxer::renderSnapshots(jobs.data(), jobs.size(), kWorkers);
+   std::chrono::milliseconds duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+   std::printf("Rendered %zu snapshots in %lld ms\n", jobs.size(), static_cast<long long>(duration.count()));
+
+   if (renderFailures > 0)
+   {
+      std::fprintf(stderr, "snapshots: %zu snapshots could not be rendered\n", renderFailures);
+      return 1;
+   }
+   if (update)
+   {
+      return 0;
+   }
+
+   int mismatches = 0;
+   for (std::size_t i = 0; i < jobs.size(); ++i)
+   {
+      std::string goldenPath = goldenDirectory + "/" + fileNames[i];
+      bool matches = boxer::compareSnapshot(jobs[i].path, goldenPath.c_str(), kTolerance);
+      mismatches += matches ? 0 : 1;
+      std::printf("%s %s\n", matches ? "ok" : "FAIL", fileNames[i].c_str());
+   }
+
+   if (mismatches > 0)
+   {
+      std::fprintf(stderr,
+                   "snapshots: %d snapshots differ from (or have no) golden images in %s\n",
+                   mismatches,
+                   goldenDirectory.c_str());
+      return 1;
+   }
+   return 0;
+}
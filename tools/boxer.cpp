@@ -0,0 +1,192 @@
+#include <boxer.hpp>
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+   const char* kUsage =
+      "Usage: boxer [--style STYLE] [--buttons BUTTONS] MESSAGE [TITLE]\n"
+      "       boxer --batch\n"
+      "\n"
+      "Shows a message box and prints the selection (e.g. OK, Cancel, Yes, No, None or Error) to stdout.\n"
+      "\n"
+      "  --style STYLE      Info, Warning, Error or Question (default: Info)\n"
+      "  --buttons BUTTONS  OK, OKCancel, YesNo, Quit or AbortRetryIgnore (default: OK)\n"
+      "  --batch            Read one request per line from stdin and print one selection per line to stdout.\n"
+      "                     Each request is 'TITLE<tab>MESSAGE[<tab>STYLE[<tab>BUTTONS]]', where '\\n', '\\t' and\n"
+      "                     '\\\\' are unescaped. The toolkit stays initialized between requests.\n";
+
+   bool equalsIgnoreCase(const std::string& a, const std::string& b)
+   {
+      if (a.size() != b.size())
+      {
+         return false;
+      }
+
+      for (std::size_t i = 0; i < a.size(); ++i)
+      {
+         if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i])))
+         {
+            return false;
+         }
+      }
+      return true;
+   }
+
+   /*!
+    * Parses a value by its std::to_string() name, ignoring case
+    */
+   template <typename T>
+   bool parse(const std::string& name, const std::vector<T>& values, T& value)
+   {
+      for (T candidate : values)
+      {
+         if (equalsIgnoreCase(name, std::to_string(candidate)))
+         {
+            value = candidate;
+            return true;
+         }
+      }
+      return false;
+   }
+
+   bool parseStyle(const std::string& name, boxer::Style& style)
+   {
+      return parse(name, { boxer::Style::Info, boxer::Style::Warning, boxer::Style::Error, boxer::Style::Question }, style);
+   }
+
+   bool parseButtons(const std::string& name, boxer::Buttons& buttons)
+   {
+      return parse(name,
+                   { boxer::Buttons::OK, boxer::Buttons::OKCancel, boxer::Buttons::YesNo, boxer::Buttons::Quit,
+                     boxer::Buttons::AbortRetryIgnore },
+                   buttons);
+   }
+
+   std::string unescape(const std::string& field)
+   {
+      std::string result;
+      result.reserve(field.size());
+      for (std::size_t i = 0; i < field.size(); ++i)
+      {
+         if (field[i] == '\\' && i + 1 < field.size())
+         {
+            char next = field[++i];
+            result += next == 'n' ? '\n' : next == 't' ? '\t' : next;
+         }
+         else
+         {
+            result += field[i];
+         }
+      }
+      return result;
+   }
+
+   std::vector<std::string> split(const std::string& line, char separator)
+   {
+      std::vector<std::string> fields;
+      std::size_t start = 0;
+      std::size_t end = 0;
+      while ((end = line.find(separator, start)) != std::string::npos)
+      {
+         fields.push_back(line.substr(start, end - start));
+         start = end + 1;
+      }
+      fields.push_back(line.substr(start));
+      return fields;
+   }
+
+   /*!
+    * Handles requests from stdin until it is closed. Invalid requests are answered with 'Error' so that the output
+    * stays in step with the input.
+    */
+   int runBatch()
+   {
+      std::string line;
+      while (std::getline(std::cin, line))
+      {
+         if (!line.empty() && line.back() == '\r')
+         {
+            line.pop_back();
+         }
+
+         std::vector<std::string> fields = split(line, '\t');
+         boxer::Style style = boxer::kDefaultStyle;
+         boxer::Buttons buttons = boxer::kDefaultButtons;
+
+         boxer::Selection selection = boxer::Selection::Error;
+         if (fields.size() >= 2 && fields.size() <= 4
+            && (fields.size() < 3 || fields[2].empty() || parseStyle(fields[2], style))
+            && (fields.size() < 4 || fields[3].empty() || parseButtons(fields[3], buttons)))
+         {
+            std::string title = unescape(fields[0]);
+            std::string message = unescape(fields[1]);
+            selection = boxer::show(message.c_str(), title.c_str(), style, buttons);
+         }
+         else
+         {
+            std::cerr << "boxer: invalid request: " << line << std::endl;
+         }
+
+         std::cout << std::to_string(selection) << std::endl;
+      }
+
+      return 0;
+   }
+} // namespace
+
+int main(int argc, char* argv[])
+{
+   boxer::Style style = boxer::kDefaultStyle;
+   boxer::Buttons buttons = boxer::kDefaultButtons;
+   std::vector<const char*> positional;
+
+   for (int i = 1; i < argc; ++i)
+   {
+      if (std::strcmp(argv[i], "--batch") == 0)
+      {
+         return runBatch();
+      }
+      else if (std::strcmp(argv[i], "--help") == 0 || std::strcmp(argv[i], "-h") == 0)
+      {
+         std::cout << kUsage;
+         return 0;
+      }
+      else if (std::strcmp(argv[i], "--style") == 0 && i + 1 < argc)
+      {
+         if (!parseStyle(argv[++i], style))
+         {
+            std::cerr << "boxer: unknown style: " << argv[i] << std::endl;
+            return 2;
+         }
+      }
+      else if (std::strcmp(argv[i], "--buttons") == 0 && i + 1 < argc)
+      {
+         if (!parseButtons(argv[++i], buttons))
+         {
+            std::cerr << "boxer: unknown buttons: " << argv[i] << std::endl;
+            return 2;
+         }
+      }
+      else
+      {
+         positional.push_back(argv[i]);
+      }
+   }
+
+   if (positional.empty() || positional.size() > 2)
+   {
+      std::cerr << kUsage;
+      return 2;
+   }
+
+   boxer::Selection selection = boxer::show(positional[0], positional.size() > 1 ? positional[1] : "", style, buttons);
+   std::cout << std::to_string(selection) << std::endl;
+
+   return selection == boxer::Selection::Error ? 1 : 0;
+}